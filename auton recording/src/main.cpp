@@ -1,5 +1,15 @@
 #include "main.h"
-#include <string>
+#include "robot/allocations.hpp"
+#include "robot/buttons.hpp"
+#include "robot/devices.hpp"
+#include "robot/loop_monitor.hpp"
+#include "robot/profile.hpp"
+#include "robot/recording.hpp"
+#include "robot/snapshot.hpp"
+#include "robot/spsc_queue.hpp"
+#include "robot/task_profiler.hpp"
+#include "robot/trace.hpp"
+#include <atomic>
 
 using namespace std;
 
@@ -11,6 +21,8 @@ using namespace std;
  */
 void initialize() {
 	pros::lcd::initialize();
+	robot::Devices::zero_arm(); // once, with the arm at rest where it starts
+	robot::Devices::calibrate(); // the inertial sensor calibrates in the background, heading hold waits for it
 }
 
 /**
@@ -44,6 +56,181 @@ void competition_initialize() {}
  */
 void autonomous() {}
 
+static robot::TaskProfiler tasks; // stack, cpu and state of every task, see robot/task_profiler.hpp
+
+/**
+ * Everything opcontrol() does, past joining the profiler. Kept out of it so none
+ * of these locals are on the stack yet when join() paints it.
+ */
+__attribute__((noinline)) static void record(int slot) {
+	robot::alloc::init([]() -> const char* { return pros::c::task_get_name(NULL); }); // count heap allocations per task, only in ALLOC_TRACE=1 builds
+	robot::profile::init([]() -> std::uint64_t { return pros::micros(); }); // time the probes below, only in PROFILE=1 builds
+	robot::trace::init([]() -> std::uint64_t { return pros::micros(); }, []() -> const char* { return pros::c::task_get_name(NULL); }); // record a timeline, only in TRACE=1 builds
+	// everything the control and display tasks use is static. Disabling the robot deletes this task and its stack, while they
+	// run until they notice and stop themselves
+	static pros::Controller master(pros::E_CONTROLLER_MASTER); // the object for the controller to get inputs
+	static robot::Devices devices; // every motor and sensor, see robot/devices.hpp
+	devices.invalidate(); // kept from the last recording, and the arm task's from whatever mode ran before, resend everything once
+	static robot::Robot robot; // conveyor, clamp, arm and drive logic shared with driver control and the replayer
+	robot = robot::Robot(); // a new recording starts from scratch, like the replay will
+
+	// the control task only ever pushes into these queues, so it never waits on the sd card or the screen
+	static robot::ButtonTracker buttons; // turns the button levels into debounced press events
+	buttons = robot::ButtonTracker(); // the new control task's time starts over at 0
+	static robot::SpscQueue<robot::RecordedCycle, 64> records; // control -> logging, a little over a second of cycles
+	struct Display { int left_y; int right_x; int arm_angle; };
+	static robot::SpscQueue<Display, 4> display; // control -> display, only the newest one gets shown
+	static atomic<bool> done; // set by the control task once the time limit is hit or the robot is disabled
+	done = false;
+	static robot::LoopMonitor monitor(robot::RobotConfig::loop_period * 1000); // how steady the control task really is, in us
+	monitor = robot::LoopMonitor(robot::RobotConfig::loop_period * 1000);
+	robot::RecordedCycle cycle;
+	while (records.pop(cycle)) {} // whatever a recording cut short by a disable left behind
+
+	static FILE* file = NULL; // static too, a disable in the middle of writing leaves it open
+	if (file != NULL) fclose(file);
+	file = fopen("/usd/recording.txt", "w"); // open the recording file with write mode, NULL without an sd card
+	static constexpr uint32_t period = robot::RobotConfig::loop_period; // ms between cycles
+	char line[96]; // one recorded cycle is well under this
+	if (file != NULL) {
+		remove("/usd/commands.txt"); // what the replay learned was for the old recording, it would steer this one down the old path
+		remove("/usd/measured.txt");
+		fwrite(line, 1, robot::format_header(line, sizeof(line), period, robot.response_curve()), file); // start with the period and curve so the replay runs at the same rate and shapes the sticks the same way
+	} else {
+		pros::lcd::print(2, "NOT RECORDING, no sd card"); // the robot still drives, the cycles just go nowhere
+	}
+	FILE* trace_file = robot::trace::enabled ? fopen("/usd/trace.bin", "wb") : NULL; // the timeline of the run, written alongside the recording in TRACE=1 builds
+	devices.wait_for_heading(); // so heading hold is on from the first recorded cycle, like it will be in the replay
+
+	// high priority task that does all the sensing and actuation, exactly once every period
+	pros::Task control([] {
+		const int control_slot = tasks.join("control", TASK_STACK_DEPTH_DEFAULT, period);
+		uint32_t time = 0; // track time to make sure the robot stops and the file gets closed at the time limit
+		uint32_t now = pros::millis();
+		while (time < robot::RobotConfig::recording_length && !pros::competition::is_disabled()) { // while loop that runs each cycle while under the time limit, stopping with the match
+			const uint64_t started = pros::micros();
+			monitor.begin(started);
+			ROBOT_TRACE_BEGIN("cycle");
+			robot::alloc::phase("sample");
+			robot::Snapshot snapshot;
+			robot::profile::time("controller read", [&] { snapshot = robot::sample(master); }); // read every controller channel once, everything below uses this
+			robot::RecordedCycle cycle; // everything that gets written to the file for this cycle
+			// the events are timed on the recording's own timeline, so the replay sees the exact same presses on the exact same cycles
+			const robot::ButtonEvents events = buttons.update(snapshot.buttons, time);
+			cycle.in = robot::controls(snapshot, events); // map the sticks and buttons to what the robot logic looks at
+			robot::alloc::phase("sense");
+			robot::profile::time("sensor read", [&] { devices.sense(cycle.in); }); // and read the sensors
+
+			robot::alloc::phase("apply");
+			const robot::Commands out = robot.step(cycle.in); // run the robot logic
+			cycle.left_power = robot.left_request(); // the drive powers it asked for, the commands the replay's learning starts from
+			cycle.right_power = robot.right_request();
+			robot::profile::time("motor write", [&] { devices.apply(out); }); // and send the result to the motors
+
+			robot::profile::time("velocity read", [&] {
+				cycle.left_velocity = devices.left_mg.device().get_actual_velocity(); // measured drive velocities, the reference the replay's learning mode tries to match
+				cycle.right_velocity = devices.right_mg.device().get_actual_velocity();
+			});
+			robot::alloc::phase("queue");
+			records.push(cycle); // hand it off to the logging task
+			display.push({snapshot.left_y, snapshot.right_x, cycle.in.arm_angle}); // and the screen
+			ROBOT_TRACE_END("cycle");
+			const uint64_t finished = pros::micros();
+			monitor.end(finished);
+			tasks.ran(control_slot, finished - started);
+
+			pros::Task::delay_until(&now, period); // Run every period then update
+			time += period; // update time variable to be accurate
+		}
+		done = true;
+		tasks.leave(control_slot); // its handle is gone once it returns
+	}, TASK_PRIORITY_MAX - 2, TASK_STACK_DEPTH_DEFAULT, "control");
+
+	// low priority task that prints whatever the control task last sent
+	pros::Task screen([] {
+		const int screen_slot = tasks.join("display", TASK_STACK_DEPTH_DEFAULT, 50);
+		Display latest;
+		robot::alloc::phase("print");
+		while (!done) {
+			const uint64_t started = pros::micros();
+			bool updated = false;
+			while (display.pop(latest)) { updated = true; } // skip to the newest
+			if (updated) {
+				ROBOT_PROBE("lcd print");
+				ROBOT_TRACE_SCOPE("lcd print");
+				pros::lcd::print(0, "left %d right %d", latest.left_y, latest.right_x);  // prints the status of the joysticks
+				pros::lcd::print(1, "rotational %d", latest.arm_angle); // prints the current rotation according to the rotation sensor for debugging purposes
+			}
+			tasks.ran(screen_slot, pros::micros() - started);
+			pros::delay(50);
+		}
+		tasks.leave(screen_slot);
+	}, TASK_PRIORITY_DEFAULT - 2, TASK_STACK_DEPTH_DEFAULT, "display");
+
+	// this task does the logging, writing cycles to the file as they come in instead of all at the end
+	robot::alloc::phase("log");
+	robot::ArmTask::get().join(tasks); // the arm's own control task, at the top of the table
+	tasks.start(); // before alloc::start(), setting it up allocates
+	robot::alloc::start(); // every task is set up, nothing should allocate from here on
+	while (!done || records.size() > 0) { // keep going until the control task is done and everything it sent is written
+		const uint64_t started = pros::micros();
+		ROBOT_TRACE_BEGIN("log");
+		while (records.pop(cycle)) { // drained even with no file, so the control task never finds the queue full
+			if (file == NULL) continue;
+			int length = robot::format_cycle(line, sizeof(line), cycle); // turn it into a line of the recording
+			robot::profile::time("file write", [&] { fwrite(line, 1, length, file); }); // and add it to the file
+		}
+		ROBOT_TRACE_END("log");
+		if (trace_file != NULL) robot::trace::flush(trace_file); // and move the timeline out of memory
+		tasks.ran(slot, pros::micros() - started);
+		pros::delay(20);
+	}
+	if (file != NULL) fclose(file); // save the file
+	file = NULL;
+	control.join();
+	screen.join();
+	robot::alloc::stop();
+	if (trace_file != NULL) { // whatever the last cycles added
+		robot::trace::flush(trace_file);
+		fclose(trace_file);
+	}
+
+	if (records.dropped() > 0) { // the sd card couldnt keep up and cycles are missing from the recording
+		pros::lcd::print(2, "dropped %d cycles", records.dropped());
+	}
+	if (robot::alloc::enabled) { // every task's allocation counts, in ALLOC_TRACE=1 builds
+		FILE* allocations_file = fopen("/usd/allocations.txt", "w");
+		if (allocations_file != NULL) {
+			robot::alloc::dump(allocations_file);
+			fclose(allocations_file);
+		}
+		robot::alloc::format_late(line, sizeof(line)); // there shouldnt be any
+		pros::lcd::print(5, "%s", line);
+	}
+	FILE* monitor_file = fopen("/usd/loop_monitor.txt", "w"); // the full timing histograms of the control task
+	if (monitor_file != NULL) {
+		monitor.dump(monitor_file);
+		fclose(monitor_file);
+	}
+	monitor.format_period(line, sizeof(line)); // and the short version on the screen
+	pros::lcd::print(3, "%s", line);
+	monitor.format_execution(line, sizeof(line));
+	pros::lcd::print(4, "%s", line);
+	tasks.format_warning(line, sizeof(line)); // a task that ran low on stack or didnt get to run
+	pros::lcd::print(6, "%s", line);
+	pros::lcd::print(7, "conveyor jams %u", (unsigned) robot.conveyor_jams()); // stalls the conveyor backed itself out of
+	if (robot::profile::enabled) { // every probe's min/mean/max, in PROFILE=1 builds
+		robot::profile::dump(stdout);
+		FILE* profile_file = fopen("/usd/profile.txt", "w");
+		if (profile_file != NULL) {
+			robot::profile::dump(profile_file);
+			fclose(profile_file);
+		}
+	}
+	pros::lcd::print(1, "DONE"); // print DONE to signal the file has been written to
+	tasks.leave(slot);
+}
+
 /**
  * Runs the operator control code. This function will be started in its own task
  * with the default priority and stack size whenever the robot is enabled via
@@ -58,127 +245,5 @@ void autonomous() {}
  * task, not resume it from where it left off.
  */
 void opcontrol() {
-	pros::Controller master(pros::E_CONTROLLER_MASTER); // the object for the controller to get inputs
-	pros::MotorGroup left_mg({1, -2, 3});    // Creates a motor group with forwards ports 1 & 3 and reversed port 2
-	pros::MotorGroup right_mg({-4, 5, -6});  // Creates a motor group with forwards port 5 and reversed ports 4 & 6
-	pros::Motor conveyor(-10); // motor for the conveyor belt
-	pros::adi::DigitalOut clamp(1); // pneumatics solenoid controlling the clamp
-	pros::Motor arm(9); // motor for the arm (lady brown mech)
-	pros::Rotation rotation(7); // rotation sensor to get location of the arm
-	pros::Optical color(16); // color sensor, ended up not using it but the light looks cool so its still in the code
-
-	color.set_led_pwm(100); // turn on the color sensor light
-
-	rotation.reset_position(); // reset rotation sensor position to 0 to make everything relative to starting position
-	const int ideal_angle = 1500; // 15 degrees
-
-	bool conveyorMoving = false; // variable to track if the conveyor is actively moving. used for checks when no button is pressed but power draw is low
-	bool clamped = false; // variable to track if the clamp is currently down. used to allow both actions to be mapped to 1 button
-	bool last_clamped = false; // variable to track if the clamp was activated or deactivated on the last cycle. used to prevent the clamp going up and down too quickly on accident
-
-	FILE* file = fopen("/usd/recording.txt", "w"); // open the recording file with write mode
-	string output = ""; // initialize the string that will be written, as this variable will be added to every cycle
-
-	int time = 0; // set the time to 0 and track it to make sure the robot stops and writes file at the time limit
-
-	while (time < 60000) { // while loop that runs each cycle while under the time limit
-		pros::lcd::print(0, "left %d right %d", master.get_analog(ANALOG_LEFT_Y), master.get_analog(ANALOG_RIGHT_X));  // prints the status of the joysticks
-		pros::lcd::print(1, "rotational %d", rotation.get_position()); // prints the current rotation according to the rotation sensor for debugging purposes
-
-		// Arcade control scheme
-		int dir = master.get_analog(ANALOG_LEFT_Y) * -1;    // Gets amount forward/backward from left joystick
-		int turn = master.get_analog(ANALOG_RIGHT_X);  // Gets the turn left/right from right joystick
-		left_mg.move(dir - turn);                      // Sets left motor voltage
-		right_mg.move(dir + turn);                     // Sets right motor voltage
-		output += to_string(dir) + ":" + to_string(turn); // add the drivetrain movement variables to the file output
-
-		// checks if buttons a, b, r1, or l1 are being pressed and stores them in corresponding variables
-		int a = master.get_digital(DIGITAL_A); // start button
-		int b = master.get_digital(DIGITAL_B); // stop button
-		int r1 = master.get_digital(DIGITAL_R1); // slow move button
-		int l1 = master.get_digital(DIGITAL_L1); // slow reverse button
-		// control flow logic for different controls regarding the conveyor
-		if (b == 1 && conveyor.get_power() > 0.1) { // if the b button is pressed and the conveyor is being powered NOTE: THIS TAKES MASSIVE PRIORITY OVER ALL CONTROLS
-			conveyor.brake(); // then brake the conveyor motor
-			conveyorMoving = false; // and update variables
-		} else if (a == 1) { // or if the a button is pressed
-			conveyor.move(127); // begin moving the conveyor at full speed
-			conveyorMoving = true; // and update variables
-		} else if (r1 == 1) { // or if the r1 button is pressed
-			conveyor.move_voltage(9000); // move at 9v out of 12v to be at a slower pace for fixing issues mid run
-			conveyorMoving = false; // and update variables
-		} else if (l1 == 1) { // or if l1 is pressed
-			conveyor.move_voltage(-9000); // move reverse at 9v out of 12v to fix issues mid run
-			conveyorMoving = false; // and update variables
-		} else if (abs(conveyor.get_current_draw()) <= 5000 && !conveyorMoving) { // and finally if the conveyor power draw is lower than 5v and the conveyor isnt supposed to be moving
-			conveyor.brake(); // then brake the conveyor motor
-			// note this is mainly to prevent issues with the conveyor not stopping after l1 or r1 is pressed or not stopping for the main a button
-		}
-        // write each button that is pressed this cycle
-        if (a) { output += "a"; }
-        if (b) { output += "b"; }
-        if (r1) { output += "r"; }
-        if (l1) { output += "l"; }
-
-		// checks if the x button is pressed
-		int x = master.get_digital(DIGITAL_X); // clamp interact button
-		if (x == 1) { // if x is pressed
-			// enter another logic flow
-			if (last_clamped) {} /* prevent flow from continuing if it x was pressed last cycle */ else if (clamped) { // if it is already clamped
-				clamp.set_value(false); // unclamp it
-				clamped = false; // and update variables
-			} else { // if it isn't already clamped
-				clamp.set_value(true); // clamp it
-				clamped = true; // and update variables
-			}
-			last_clamped = true; // update variables at end to say x was pressed this (which will be last) cycle
-		} else { // or if x isn't pressed
-			last_clamped = false; // update variables to reflect this for next cycle
-		}
-        // write if x is pressed this cycle
-        if (x) { output += "x"; }
-
-		// checks if y, l2, or r2 are pressed
-		int y = master.get_digital(DIGITAL_Y); // prime button
-		int l2 = master.get_digital(DIGITAL_L2); // reverse button
-		int r2 = master.get_digital(DIGITAL_R2); // forward button
-		if (y == 1) { // if y is pressed
-			const int current_angle = rotation.get_position(); // get the current angle of the arm
-			if (current_angle != ideal_angle) { // and check to make sure it is not already at the ideal angle (not possible btw)
-				arm.move_relative(ideal_angle + current_angle, 100); // and then move it the proper relative angle to move toward the ideal angle set earlier
-			}
-		} else if (l2 == 1) { // or if l2 is pressed
-			arm.move(-30); // reverse the arm at 30/127 speed
-		} else if (r2 == 1) { // or if r2 is pressed
-			arm.move(30); // move the arm forward at 30/127 speed
-		} else { // if none are pressed
-			arm.move(0); // stop the arm from moving
-			arm.set_brake_mode(pros::E_MOTOR_BRAKE_HOLD); // set the brake mode to hold
-			arm.brake(); // and brake
-			// the holding brakes should prevent the arm from falling from the force of gravity if in the air
-		}
-        // write each button that is pressed this cycle
-		if (y) { output += "y"; }
-		if (l2) { output += "L"; }
-		if (r2) { output += "R"; }
-
-
-        output += "\n"; // add a newline to signal the next cycle
-		pros::delay(20);                               // Run for 20 ms then update
-		time += 20; // update time variable to be accurate
-	}
-
-    // write output variable to file
-	try {
-		const char* charPtr = output.c_str(); // cast string output as a char*
-		char charArray[output.length() + 1]; // initialize the charArray variable
-		strcpy(charArray, charPtr); // write the contents of charPtr to charArray
-		fputs(charArray, file); // add the contents of charArray to the file and save it
-	} catch (const int e) { // handle errors
-		char* error;
-		itoa(e, error, 100); // make integer into a char* to be able to print it
-		pros::lcd::print(3, error); // print the error code to the v5 brain screen
-	}
-
-	pros::lcd::print(1, "DONE"); // print DONE to signal the file has been written to
-}
\ No newline at end of file
+	record(tasks.join("opcontrol", TASK_STACK_DEPTH_DEFAULT, 20)); // before record() takes up any stack, see TaskProfiler::join
+}
@@ -1,5 +1,18 @@
 #include "main.h"
+#include "robot/allocations.hpp"
+#include "robot/buttons.hpp"
+#include "robot/devices.hpp"
+#include "robot/ilc.hpp"
+#include "robot/loop_monitor.hpp"
+#include "robot/profile.hpp"
+#include "robot/recording.hpp"
+#include "robot/task_profiler.hpp"
+#include "robot/trace.hpp"
+#include <atomic>
+#include <algorithm>
+#include <cstring>
 #include <string>
+#include <vector>
 
 using namespace std;
 
@@ -11,6 +24,8 @@ using namespace std;
  */
 void initialize() {
 	pros::lcd::initialize();
+	robot::Devices::zero_arm(); // once, with the arm at rest where it starts
+	robot::Devices::calibrate(); // the inertial sensor calibrates in the background, heading hold waits for it
 	autonomous();
 }
 
@@ -19,7 +34,47 @@ void initialize() {
  * the VEX Competition Switch, following either autonomous or opcontrol. When
  * the robot is enabled, this task will exit.
  */
-void disabled() {}
+void disabled() {
+	// iterative learning: fold the last replay's tracking error into the commands for the next replay
+	FILE* measured_file = fopen("/usd/measured.txt", "r"); // what the robot actually did on the last replay
+	if (measured_file == NULL) {return;} // nothing has been replayed yet
+	vector<robot::ilc::Frame> measured = robot::ilc::read_frames(measured_file, NULL);
+	fclose(measured_file);
+	if (measured.empty()) {return;} // already learned from this replay
+
+	FILE* recording = fopen("/usd/recording.txt", "r"); // the reference is what the robot measured while recording
+	if (recording == NULL) {return;}
+	vector<robot::ilc::Frame> commands, reference;
+	robot::ilc::Gains gains;
+	bool has_arm = false;
+	robot::ilc::read_recording(recording, robot::Robot::curves, &commands, &reference, &gains.period, &has_arm); // the leads are in ms, so learning needs the recording's period
+	if (!has_arm) gains.arm = 0; // older recordings have no arm angle, the replay runs their arm off the buttons
+	fclose(recording);
+
+	if (commands.empty()) {return;} // nothing recorded, nothing to learn
+	int iteration = 0; // how many times the commands have been refined
+	FILE* commands_file = fopen("/usd/commands.txt", "r");
+	if (commands_file != NULL) { // if there are refined commands keep refining them, otherwise start from the recording
+		int refined_iteration = 0;
+		vector<robot::ilc::Frame> refined = robot::ilc::read_frames(commands_file, &refined_iteration);
+		fclose(commands_file);
+		if (!refined.empty()) { // an empty or cut off file has nothing to refine, start over from the recording
+			commands = refined;
+			iteration = refined_iteration;
+		}
+	}
+
+	robot::ilc::Error error = robot::ilc::update(reference, measured, commands, gains);
+
+	commands_file = fopen("/usd/commands.txt", "w"); // write the refined commands for the next replay
+	if (commands_file == NULL) {return;}
+	robot::ilc::write_frames(commands_file, commands, iteration + 1);
+	fclose(commands_file);
+	measured_file = fopen("/usd/measured.txt", "w"); // empty the measurements so the same replay isnt learned twice
+	if (measured_file != NULL) {fclose(measured_file);}
+
+	pros::lcd::print(2, "ilc %d drive %d rpm arm %d", iteration + 1, (int) error.drive, (int) error.arm); // show the tracking error so convergence can be watched between runs
+}
 
 /**
  * Runs after initialize(), and before autonomous when connected to the Field
@@ -32,122 +87,197 @@ void disabled() {}
  */
 void competition_initialize() {}
 
+static robot::TaskProfiler tasks; // stack, cpu and state of every task, see robot/task_profiler.hpp
+
 /**
- * Runs the user autonomous code. This function will be started in its own task
- * with the default priority and stack size whenever the robot is enabled via
- * the Field Management System or the VEX Competition Switch in the autonomous
- * mode. Alternatively, this function may be called in initialize or opcontrol
- * for non-competition testing purposes.
- *
- * If the robot is disabled or communications is lost, the autonomous task
- * will be stopped. Re-enabling the robot will restart the task, not re-start it
- * from where it left off.
+ * Everything autonomous() does, past joining the profiler. Kept out of it so none
+ * of these locals are on the stack yet when join() paints it.
  */
-void autonomous() {
-	pros::Controller master(pros::E_CONTROLLER_MASTER); // the object for the controller to get inputs
-	pros::MotorGroup left_mg({1, -2, 3});    // Creates a motor group with forwards ports 1 & 3 and reversed port 2
-	pros::MotorGroup right_mg({-4, 5, -6});  // Creates a motor group with forwards port 5 and reversed ports 4 & 6
-	pros::Motor conveyor(-10); // motor for the conveyor belt
-    pros::adi::DigitalOut clamp(1); // pneumatics solenoid controlling the clamp
-    pros::Motor arm(9); // motor for the arm (lady brown mech)
-    pros::Rotation rotation(7); // rotation sensor to get location of the arm
-    pros::Optical color(16); // color sensor, ended up not using it but the light looks cool so its still in the code
-
-    color.set_led_pwm(100); // turn on the color sensor light
-
-    rotation.reset_position(); // reset rotation sensor position to 0 to make everything relative to starting position
-    const int ideal_angle = 1500; // 15 degrees
-
-	bool conveyorMoving = false; // variable to track if the conveyor is actively moving. used for checks when no button is pressed but power draw is low
-    bool clamped = false; // variable to track if the clamp is currently down. used to allow both actions to be mapped to 1 button
-	bool last_clamped = false; // variable to track if the clamp was activated or deactivated on the last cycle. used to prevent the clamp going up and down too quickly on accident
+__attribute__((noinline)) static void replay(int slot) {
+	robot::alloc::init([]() -> const char* { return pros::c::task_get_name(NULL); }); // count heap allocations per task, only in ALLOC_TRACE=1 builds
+	robot::alloc::phase("load");
+	robot::profile::init([]() -> std::uint64_t { return pros::micros(); }); // time the probes below, only in PROFILE=1 builds
+	robot::trace::init([]() -> std::uint64_t { return pros::micros(); }, []() -> const char* { return pros::c::task_get_name(NULL); }); // record a timeline, only in TRACE=1 builds
+	robot::Devices devices; // every motor and sensor, see robot/devices.hpp
+	devices.invalidate(); // the arm task's cache outlives the last mode, resend everything once
+	robot::Robot robot; // conveyor, clamp, arm and drive logic shared with driver control and the recorder
+	robot::ButtonTracker buttons; // turns the recorded button levels into the same press events the recorder saw
 
 	FILE* file = fopen("/usd/recording.txt", "r"); // open the saved auton recording file
-	if (file == NULL) {return;} // if the file is unavailable or broken
-	char buf[100000]; // create a buffer variable for the file contents
-	fread(buf, 1, 100000, file); // read the file and add the contents to the buf variable
+	if (file == NULL) { // if the file is unavailable or broken
+		tasks.leave(slot);
+		return;
+	}
+	static char buf[100000]; // create a buffer variable for the file contents, static since its three times the size of the task's whole stack
+	size_t length;
+	robot::profile::time("file read", [&] { length = fread(buf, 1, sizeof(buf) - 1, file); }); // read the file and add the contents to the buf variable
+	buf[length] = '\0'; // end it where the file ends, so nothing below reads past it
+	fclose(file);
 
 	int time = 0; // create a variable to keep track of time, not entirely necessary but preferred
 
+	vector<robot::ilc::Frame> commands; // refined drive and arm commands from iterative learning, empty if there are none yet
+	FILE* commands_file = fopen("/usd/commands.txt", "r");
+	if (commands_file != NULL) {
+		commands = robot::ilc::read_frames(commands_file, NULL);
+		fclose(commands_file);
+	}
     // split the string using a newline delimiter
 	vector<char*> instr; // create the instr variable as a list of char*s
-	char* add = strtok(buf, "\n"); // get first index of split strings
-	do { // while loop but it will run at least once
+	instr.reserve(count(buf, buf + length, '\n') + 1); // one line per newline, so it never grows while splitting
+	for (char* add = strtok(buf, "\n"); add != NULL; add = strtok(NULL, "\n")) { // each line, none at all for an empty file
 		instr.push_back(add); // add the char* to the instr list
-		add = strtok(NULL, "\n"); // update add variable to be the next index of the split strings
-	} while (add); // if theres no value for add, stop adding variables
+	}
 
-	for (int i = 0; i <= instr.size(); i++) { // for each instruction in the instr variable
+	uint32_t period = robot::legacy_period; // ms per line, recordings without a header were all made at 20 ms
+	robot::ResponseCurve curve = robot::ResponseCurve::Linear; // and were driven without a curve
+	if (!instr.empty() && robot::parse_header(instr[0], &period, &curve)) { // newer recordings say what period they were made at and on which curve
+		instr.erase(instr.begin()); // the header isnt a cycle
+	}
+	if (instr.empty()) { // nothing was recorded, so there is nothing to replay
+		pros::lcd::print(1, "EMPTY RECORDING");
+		tasks.leave(slot);
+		return;
+	}
+	robot.use_curve(curve);
+	robot::LoopMonitor monitor(period * 1000); // how steadily the replay keeps the recorded period, in us
+	string measured; // what the robot actually did each cycle, written to the sd card at the end for learning
+	measured.reserve(instr.size() * 24); // "-600:-600:-2147483648\n" is the longest line, so it never grows during the run
+	char line[48]; // one measured line
+	uint32_t now = pros::millis();
+
+	static atomic<bool> replaying; // tells the trace writer when to stop
+	replaying = true;
+	pros::Task* trace_writer = NULL;
+	if (robot::trace::enabled) { // low priority task that moves the timeline to the sd card while the replay runs
+		trace_writer = new pros::Task([] {
+			const int trace_slot = tasks.join("trace", TASK_STACK_DEPTH_DEFAULT, 0);
+			FILE* trace_file = fopen("/usd/trace.bin", "wb");
+			if (trace_file != NULL) {
+				while (replaying) {
+					robot::trace::flush(trace_file);
+					pros::delay(50);
+				}
+				robot::trace::flush(trace_file); // whatever the last cycles added
+				fclose(trace_file);
+			}
+			tasks.leave(trace_slot); // its handle is gone once it returns
+		}, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "trace");
+	}
+
+	devices.wait_for_heading(); // initialize() only just started the calibration, and the recording held its heading from the start
+	robot::ArmTask::get().join(tasks); // the arm's own control task, at the top of the table
+	tasks.start(); // before alloc::start(), setting it up allocates
+	robot::alloc::start(); // everything is loaded, nothing should allocate from here on
+	for (size_t i = 0; i < instr.size(); i++) { // for each instruction in the instr variable
+		const uint64_t started = pros::micros();
+		monitor.begin(started);
+		ROBOT_TRACE_BEGIN("cycle");
+		robot::alloc::phase("parse");
 		char* current = instr[i]; // make it into a new variable for easier use
-        string currentStr = current; // cast it to a string
-
-		char delimiter = ':'; // has to be a pointer so make it a variable
-		char* token = strtok(current, &delimiter); // split string based on delimiter value
-		int dir = atoi(token);    // Gets amount forward/backward from left joystick
-		token = strtok(NULL, &delimiter); // get second index of split string
-		int turn = atoi(token);  // Gets the turn left/right from right joystick
-		left_mg.move(dir - turn);                      // Sets left motor voltage
-		right_mg.move(dir + turn);                     // Sets right motor voltage
-		int a, b, r1, l1; // get values for buttons a, b, r1, and l1
-		if (currentStr.find("a") != string::npos) { a = 1; } else { a = 0; } // every button is checked by seeing if the letter is anywhere in the current cycle string since everything but the buttons are numbers and symbols anyway
-		if (currentStr.find("b") != string::npos) { b = 1; } else { b = 0; }
-		if (currentStr.find("r") != string::npos) { r1 = 1; } else { r1 = 0; }
-		if (currentStr.find("l") != string::npos) { l1 = 1; } else { l1 = 0; }
-		if (b == 1 && conveyor.get_power() > 0.1) { // if the b button is pressed and the conveyor is being powered NOTE: THIS TAKES MASSIVE PRIORITY OVER ALL CONTROLS
-			conveyor.brake(); // then brake the conveyor motor
-			conveyorMoving = false; // and update variables
-		} else if (a == 1) { // or if the a button is pressed
-			conveyor.move(127); // begin moving the conveyor at full speed
-			conveyorMoving = true; // and update variables
-		} else if (r1 == 1) { // or if the r1 button is pressed
-			conveyor.move_voltage(9000); // move at 9v out of 12v to be at a slower pace for fixing issues mid run
-			conveyorMoving = false; // and update variables
-		} else if (l1 == 1) { // or if l1 is pressed
-			conveyor.move_voltage(-9000); // move reverse at 9v out of 12v to fix issues mid run
-			conveyorMoving = false; // and update variables
-		} else if (abs(conveyor.get_current_draw()) <= 5000 && !conveyorMoving) { // and finally if the conveyor power draw is lower than 5v and the conveyor isnt supposed to be moving
-			conveyor.brake(); // then brake the conveyor motor
-            // note this is mainly to prevent issues with the conveyor not stopping after l1 or r1 is pressed or not stopping for the main a button
-		}
-        int x; // check if x is pressed
-        if (currentStr.find("x") != string::npos) { x = 1; } else { x = 0; }
-		if (x == 1) { // if x is pressed
-          	// enter another logic flow
-			if (last_clamped) {} /* prevent flow from continuing if it x was pressed last cycle */ else if (clamped) { // if it is already clamped
-            	clamp.set_value(false); // unclamp it
-                clamped = false; // and update variables
-            } else { // if it isn't already clamped
-            	clamp.set_value(true); // clamp it
-                clamped = true; // and update variables
-            }
-			last_clamped = true; // update variables at end to say x was pressed this (which will be last) cycle
-        } else { // or if x isn't pressed
-			last_clamped = false; // update variables to reflect this for next cycle
-		}
-        int y, l2, r2; // check if y, l2 or r2 are pressed
-        if (currentStr.find("y") != string::npos) { y = 1; } else { y = 0; }
-        if (currentStr.find("L") != string::npos) { l2 = 1; } else { l2 = 0; }
-        if (currentStr.find("R") != string::npos) { r2 = 1; } else { r2 = 0; }
-        if (y == 1) { // if y is pressed
-			const int current_angle = rotation.get_position(); // get the current angle of the arm
-			if (current_angle != ideal_angle) { // and check to make sure it is not already at the ideal angle (not possible btw)
-				arm.move_relative(ideal_angle + current_angle, 100); // and then move it the proper relative angle to move toward the ideal angle set earlier
+
+		robot::Snapshot snapshot; // rebuild what the controller read on this cycle of the recording
+		snapshot.buttons = robot::parse_buttons(current); // which buttons were held, before strtok cuts the line up
+		char* token = strtok(current, ":"); // split string based on the ':' delimiter
+		snapshot.left_y = token ? -atoi(token) : 0;    // Gets amount forward/backward from left joystick, a line that is only ':'s has none
+		token = strtok(NULL, ":"); // get second index of split string
+		snapshot.right_x = token ? atoi(token) : 0;  // Gets the turn left/right from right joystick
+		token = strtok(NULL, ":"); // get third index of split string, the recorded arm angle (older recordings dont have it)
+		const bool has_angle = token != NULL; // if there is an angle then follow it instead of replaying the arm buttons
+		const int angle = has_angle ? atoi(token) : 0; // the rotation sensor position the arm was at while recording
+		snapshot.time = time; // on the same timeline the recorder used, so the button events land on the same cycles
+
+		robot::Inputs in = robot::controls(snapshot, buttons.update(snapshot.buttons, snapshot.time)); // exactly the mapping the recorder used
+		in.has_arm_target = has_angle;
+		in.arm_target = angle;
+		if (i < commands.size()) { // if learning has refined this cycle then follow its arm target and drive commands instead of the raw recording
+			if (has_angle) { // a recording without angles learns nothing for the arm, it stays on the buttons
+				in.arm_target = commands[i].arm;
+				in.has_arm_target = true;
 			}
-        } else if (l2 == 1) { // or if l2 is pressed
-			arm.move(-30); // reverse the arm at 30/127 speed
-        } else if (r2 == 1) { // or if r2 is pressed
-			arm.move(30); // move the arm forward at 30/127 speed
-        } else { // if none are pressed
-			arm.move(0); // stop the arm from moving
-			arm.set_brake_mode(pros::E_MOTOR_BRAKE_HOLD); // set the brake mode to hold
-			arm.brake(); // and brake
-            // the holding brakes should prevent the arm from falling from the force of gravity if in the air
+			in.drive_left = commands[i].left;
+			in.drive_right = commands[i].right;
+			in.has_drive = true;
 		}
-		pros::delay(20);                               // Run for 20 ms then update
-		time += 20; // update time variable to be accurate
+		robot::alloc::phase("sense");
+		robot::profile::time("sensor read", [&] { devices.sense(in); }); // and the sensors
+
+		robot::alloc::phase("apply");
+		robot::Commands out = robot.step(in); // run the exact same logic driver control ran while recording
+		robot::profile::time("motor write", [&] { devices.apply(out); });
+
+		// log the measured drive velocities and arm angle so disabled() can compare them to the recording
+		robot::alloc::phase("measure");
+		robot::profile::time("measure", [&] { // velocities and angle, formatted into the log
+			int length = snprintf(line, sizeof(line), "%d:%d:%d\n", (int) devices.left_mg.device().get_actual_velocity(), (int) devices.right_mg.device().get_actual_velocity(), (int) devices.rotation.get_position());
+			measured.append(line, length);
+		});
+		ROBOT_TRACE_END("cycle");
+		const uint64_t finished = pros::micros();
+		monitor.end(finished);
+		tasks.ran(slot, finished - started);
+		pros::Task::delay_until(&now, period);                               // Run at the period it was recorded at then update
+		time += period; // update time variable to be accurate
+	}
+	robot::alloc::stop();
+	if (trace_writer != NULL) { // let it write the rest of the timeline
+		replaying = false;
+		trace_writer->join();
+		delete trace_writer;
 	}
 
+	FILE* measured_file = fopen("/usd/measured.txt", "w"); // save the measurements for learning once the robot is disabled
+	if (measured_file != NULL) {
+		robot::profile::time("file write", [&] { fputs(measured.c_str(), measured_file); });
+		fclose(measured_file);
+	}
+	FILE* monitor_file = fopen("/usd/loop_monitor.txt", "w"); // the full timing histograms of the replay loop
+	if (monitor_file != NULL) {
+		monitor.dump(monitor_file);
+		fclose(monitor_file);
+	}
+	monitor.format_period(line, sizeof(line)); // and the short version on the screen
+	pros::lcd::print(3, "%s", line);
+	monitor.format_execution(line, sizeof(line));
+	pros::lcd::print(4, "%s", line);
+	if (robot::alloc::enabled) { // every task's allocation counts, in ALLOC_TRACE=1 builds
+		FILE* allocations_file = fopen("/usd/allocations.txt", "w");
+		if (allocations_file != NULL) {
+			robot::alloc::dump(allocations_file);
+			fclose(allocations_file);
+		}
+		robot::alloc::format_late(line, sizeof(line)); // there shouldnt be any
+		pros::lcd::print(5, "%s", line);
+	}
+	tasks.format_warning(line, sizeof(line)); // a task that ran low on stack or didnt get to run
+	pros::lcd::print(6, "%s", line);
+	pros::lcd::print(7, "conveyor jams %u", (unsigned) robot.conveyor_jams()); // stalls the conveyor backed itself out of
+
+	if (robot::profile::enabled) { // every probe's min/mean/max, in PROFILE=1 builds
+		robot::profile::dump(stdout);
+		FILE* profile_file = fopen("/usd/profile.txt", "w");
+		if (profile_file != NULL) {
+			robot::profile::dump(profile_file);
+			fclose(profile_file);
+		}
+	}
 	pros::lcd::print(1, "DONE"); // print done to screen to indicate auton is over
+	tasks.leave(slot);
+}
+
+/**
+ * Runs the user autonomous code. This function will be started in its own task
+ * with the default priority and stack size whenever the robot is enabled via
+ * the Field Management System or the VEX Competition Switch in the autonomous
+ * mode. Alternatively, this function may be called in initialize or opcontrol
+ * for non-competition testing purposes.
+ *
+ * If the robot is disabled or communications is lost, the autonomous task
+ * will be stopped. Re-enabling the robot will restart the task, not re-start it
+ * from where it left off.
+ */
+void autonomous() {
+	replay(tasks.join("autonomous", TASK_STACK_DEPTH_DEFAULT, robot::legacy_period)); // before replay() takes up any stack, see TaskProfiler::join
 }
 
 /**
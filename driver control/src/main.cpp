@@ -1,6 +1,19 @@
 #include "main.h"
+#include "robot/allocations.hpp"
+#include "robot/buttons.hpp"
+#include "robot/devices.hpp"
+#include "robot/executive.hpp"
+#include "robot/loop_monitor.hpp"
+#include "robot/profile.hpp"
+#include "robot/sequencer.hpp"
+#include "robot/snapshot.hpp"
+#include "robot/task_profiler.hpp"
+#include "robot/trace.hpp"
 #include <cmath>
 
+static robot::RingColor rejected = robot::RingColor::None; // the other alliance's rings, picked in competition_initialize
+static bool run_example = false; // whether autonomous() runs its untuned example routine, also picked there
+
 /**
  * Runs initialization code. This occurs as soon as the program is started.
  *
@@ -9,6 +22,8 @@
  */
 void initialize() {
 	pros::lcd::initialize();
+	robot::Devices::zero_arm(); // once, with the arm at rest where it starts
+	robot::Devices::calibrate(); // the inertial sensor calibrates in the background, heading hold waits for it
 }
 
 /**
@@ -27,7 +42,21 @@ void disabled() {}
  * This task will exit when the robot is enabled and autonomous or opcontrol
  * starts.
  */
-void competition_initialize() {}
+void competition_initialize() {
+	pros::Controller master(pros::E_CONTROLLER_MASTER);
+	while (true) { // pick the alliance on the screen, the sorter throws out the other color
+		const std::uint8_t buttons = pros::lcd::read_buttons();
+		if (buttons & LCD_BTN_LEFT) rejected = robot::RingColor::Blue; // red alliance
+		if (buttons & LCD_BTN_CENTER) rejected = robot::RingColor::None; // keep everything
+		if (buttons & LCD_BTN_RIGHT) rejected = robot::RingColor::Red; // blue alliance
+		pros::lcd::print(0, "sorting out %s: red < none > blue", robot::name(rejected));
+		// and the autonomous routine on the controller, nothing unless asked for since the example isnt tuned on a field
+		if (master.get_digital(pros::E_CONTROLLER_DIGITAL_A)) run_example = true;
+		if (master.get_digital(pros::E_CONTROLLER_DIGITAL_B)) run_example = false;
+		pros::lcd::print(1, "auton %s: A example, B none", run_example ? "example" : "none");
+		pros::delay(50);
+	}
+}
 
 /**
  * Runs the user autonomous code. This function will be started in its own task
@@ -40,7 +69,206 @@ void competition_initialize() {}
  * will be stopped. Re-enabling the robot will restart the task, not re-start it
  * from where it left off.
  */
-void autonomous() {}
+void autonomous() {
+	if (!run_example) return; // picked in competition_initialize, off by default
+	robot::Devices devices; // every motor and sensor, see robot/devices.hpp
+	devices.invalidate(); // the arm task's cache outlives the last mode, resend everything once
+	robot::Robot robot; // same logic as driver control, the routine only sets what the buttons would
+	robot::auton::Sequencer sequencer(robot::auton::sequencer_settings<robot::RobotConfig>()); // runs the routine below a tick at a time, see robot/sequencer.hpp
+	robot.sort_out(rejected);
+
+	sequencer.start([]() -> robot::auton::Routine {
+		using namespace robot::auton;
+		co_await drive_to(-900); // back into the mobile goal, in degrees of wheel rotation
+		co_await clamp(true);
+		co_await wait(200); // let the clamp close before pulling on the goal
+		co_await conveyor(127); // score the preload
+		co_await all(drive_to(0), arm_to(robot::ArmPreset::Load)); // drive back and prime the arm at the same time
+		co_await wait(1500);
+		co_await conveyor(0);
+	}());
+
+	std::uint32_t now = pros::millis();
+	while (!sequencer.done()) { // one control cycle per loop, every step is resumed from in here
+		robot::Inputs in;
+		in.time = now;
+		devices.sense(in);
+		devices.sense_drive(in);
+		sequencer.tick(now, in);
+		robot::Commands out = robot.step(in);
+		sequencer.apply(out);
+		devices.apply(out);
+		pros::Task::delay_until(&now, robot::RobotConfig::loop_period);
+	}
+	devices.apply_drive(robot::Commands{}); // the slew limiters may still have been easing off, the clamp and arm keep what they were sent
+}
+
+static robot::TaskProfiler tasks; // stack, cpu and state of every task, see robot/task_profiler.hpp
+
+/**
+ * Everything opcontrol() does, past joining the profiler. Kept out of it so none
+ * of these locals are on the stack yet when join() paints it.
+ */
+__attribute__((noinline)) static void drive(int slot) {
+	// everything the subsystems share, handed to each of them as their context
+	struct Driver {
+		pros::Controller master{pros::E_CONTROLLER_MASTER}; // the object for the controller to get inputs
+		robot::Devices devices; // every motor and sensor, see robot/devices.hpp
+		robot::Robot robot; // conveyor, clamp, arm and drive logic shared with the auton recorder and replayer
+		robot::Snapshot snapshot; // the latest controller reading
+		robot::ButtonTracker buttons; // turns the button levels into debounced press events
+		robot::Inputs in; // what the robot logic looks at
+		robot::Commands out; // what the robot logic last asked for
+		robot::WriteCounter arm_writes; // the arm task's counts as of the last display update, it never resets them
+		const robot::Executive* executive = nullptr; // for showing how long each subsystem takes
+		const robot::LoopMonitor* monitor = nullptr; // for showing how steady the loop itself is
+		const robot::TaskProfiler* tasks = nullptr; // for showing task problems
+	};
+	robot::alloc::init([]() -> const char* { return pros::c::task_get_name(NULL); }); // count heap allocations per task, only in ALLOC_TRACE=1 builds
+	robot::profile::init([]() -> std::uint64_t { return pros::micros(); }); // time the probes below, only in PROFILE=1 builds
+	robot::trace::init([]() -> std::uint64_t { return pros::micros(); }, []() -> const char* { return pros::c::task_get_name(NULL); }); // record a timeline, only in TRACE=1 builds
+	Driver driver;
+	driver.devices.invalidate(); // the arm task's cache outlives the last mode, resend everything once
+	driver.robot.sort_out(rejected);
+
+	robot::Executive executive([]() -> std::uint64_t { return pros::micros(); }); // runs each subsystem at its own rate, timing each one
+	// runs in this order whenever more than one is due
+	executive.add("input", robot::RobotConfig::loop_period, 0, [](void* context) { // read every controller channel once, everything else uses this
+		Driver& d = *static_cast<Driver*>(context);
+		robot::alloc::phase("input");
+		ROBOT_TRACE_SCOPE("input");
+		robot::profile::time("controller read", [&] { d.snapshot = robot::sample(d.master); });
+		robot::Inputs controls = robot::controls(d.snapshot, d.buttons.update(d.snapshot.buttons, d.snapshot.time));
+		controls.arm_angle = d.in.arm_angle; // keep the sensor readings, those are refreshed by their own subsystems
+		controls.conveyor_power = d.in.conveyor_power;
+		controls.conveyor_current = d.in.conveyor_current;
+		controls.conveyor_velocity = d.in.conveyor_velocity;
+		controls.conveyor_torque = d.in.conveyor_torque;
+		controls.conveyor_position = d.in.conveyor_position;
+		controls.ring_proximity = d.in.ring_proximity;
+		controls.ring_hue = d.in.ring_hue;
+		// the clamp only runs every other tick, so its toggle waits for it rather than being overwritten by the next tick's controls.
+		// presses are debounced for longer than the clamp's period, so one flag never has two presses to hold. arm_preset needs no
+		// latch, the arm runs on every tick right after this
+		controls.clamp_toggle = controls.clamp_toggle || d.in.clamp_toggle;
+		d.in = controls;
+	}, &driver);
+	executive.add("arm", robot::RobotConfig::loop_period, 0, [](void* context) { // decides what the arm should do, the arm task does the fast control on the rotation sensor
+		Driver& d = *static_cast<Driver*>(context);
+		robot::alloc::phase("arm");
+		ROBOT_TRACE_SCOPE("arm");
+		robot::profile::time("arm sensor read", [&] { d.devices.sense_arm(d.in); });
+		d.robot.arm(d.in, d.out);
+		robot::profile::time("arm command", [&] { d.devices.apply_arm(d.out); });
+	}, &driver);
+	executive.add("drive", robot::RobotConfig::loop_period, 0, [](void* context) { // every control cycle, right after the input it uses
+		Driver& d = *static_cast<Driver*>(context);
+		robot::alloc::phase("drive");
+		ROBOT_TRACE_SCOPE("drive");
+		robot::profile::time("drive sensor read", [&] {
+			d.devices.sense_drive_current(d.in);
+			d.devices.sense_heading(d.in);
+		});
+		d.robot.drive(d.in, d.out);
+		robot::profile::time("drive motor write", [&] { d.devices.apply_drive(d.out); });
+	}, &driver);
+	executive.add("mechanisms", 20, 5, [](void* context) { // conveyor and clamp, offset so they dont land on the same tick as the drive
+		Driver& d = *static_cast<Driver*>(context);
+		robot::alloc::phase("mechanisms");
+		ROBOT_TRACE_SCOPE("mechanisms");
+		robot::profile::time("conveyor sensor read", [&] { d.devices.sense_conveyor(d.in); });
+		d.robot.conveyor(d.in, d.out);
+		if (robot::trace::enabled && d.robot.rings().reached(robot::RingMark::Arm)) ROBOT_TRACE_INSTANT("ring at arm"); // on the timeline, for checking the marks against video
+		if (robot::trace::enabled && d.robot.rings().reached(robot::RingMark::Top)) ROBOT_TRACE_INSTANT("ring at top");
+		d.robot.clamp(d.in, d.out);
+		d.in.clamp_toggle = false; // used up, see the input subsystem
+		robot::profile::time("mechanism motor write", [&] {
+			d.devices.apply_conveyor(d.out);
+			d.devices.apply_clamp(d.out);
+		});
+	}, &driver);
+	executive.add("display", 100, 15, [](void* context) { // the screen only needs to be readable
+		Driver& d = *static_cast<Driver*>(context);
+		robot::alloc::phase("display");
+		ROBOT_TRACE_SCOPE("display");
+		if (robot::alloc::enabled && (pros::lcd::read_buttons() & LCD_BTN_LEFT)) { // left screen button saves every task's allocation counts, in ALLOC_TRACE=1 builds
+			robot::alloc::stop(); // the file itself allocates, so dont count it
+			FILE* file = fopen("/usd/allocations.txt", "w");
+			if (file != NULL) {
+				robot::alloc::dump(file);
+				fclose(file);
+			}
+			robot::alloc::start();
+		}
+		if (robot::profile::enabled && (pros::lcd::read_buttons() & LCD_BTN_RIGHT)) { // right screen button prints every probe's min/mean/max to the terminal and saves it, in PROFILE=1 builds
+			robot::profile::dump(stdout);
+			robot::profile::time("file write", [] {
+				FILE* file = fopen("/usd/profile.txt", "w");
+				if (file != NULL) {
+					robot::profile::dump(file);
+					fclose(file);
+				}
+			});
+		}
+		ROBOT_PROBE("lcd print"); // everything from here on is the screen
+		pros::lcd::print(0, "left %d right %d heading %d%s", d.snapshot.left_y, d.snapshot.right_x, (int) d.in.heading, d.in.has_heading ? d.robot.holding_heading() ? " held" : "" : " calibrating");  // prints the status of the joysticks and the heading
+		pros::lcd::print(1, "rotational %d %s%s", d.in.arm_angle, robot::name(d.robot.arm_preset()), d.robot.arm_state() == robot::ArmState::AtPreset ? "" : d.robot.arm_state() == robot::ArmState::Moving ? "..." : " off"); // the current rotation according to the rotation sensor, and the preset the arm is at, heading to (...) or was last at (off)
+		const robot::WriteCounter arm = robot::ArmTask::get().writes; // copied once, the arm task keeps counting while this runs
+		pros::lcd::print(2, "per 100ms sent %u skip %u arm %u/%u jams %u", (unsigned) d.devices.writes.sent, (unsigned) d.devices.writes.suppressed, (unsigned) (arm.sent - d.arm_writes.sent), (unsigned) (arm.suppressed - d.arm_writes.suppressed), (unsigned) d.robot.conveyor_jams()); // device writes sent and saved by the actuator cache since the last update (this subsystem's period), the arm task's own sent/skipped, and conveyor jams cleared
+		d.devices.writes.reset();
+		d.arm_writes = arm;
+		if (pros::lcd::read_buttons() & LCD_BTN_CENTER) { // hold the middle screen button to see the loop timing instead of the subsystems
+			char line[48];
+			d.monitor->format_period(line, sizeof(line)); // min/mean/max time between ticks
+			pros::lcd::print(3, "%s", line);
+			d.monitor->format_execution(line, sizeof(line)); // min/mean/max time each tick took, and how many went past their period
+			pros::lcd::print(4, "%s", line);
+			robot::alloc::format_late(line, sizeof(line)); // heap allocations since the loop started, there should be none
+			pros::lcd::print(5, "%s", line);
+			d.tasks->format_warning(line, sizeof(line)); // a task low on stack or not getting to run
+			pros::lcd::print(6, "%s", line);
+			d.robot.sorting().format(line, sizeof(line)); // rings thrown out, how long from seeing each to stopping for it and how far past the mark
+			pros::lcd::print(7, "%s", line);
+			return;
+		}
+		for (std::size_t i = 0; i < d.executive->size(); i++) { // mean and worst execution time of every subsystem
+			const robot::Executive::Stats& stats = d.executive->stats(i);
+			pros::lcd::print(3 + i, "%s %d us max %d us", d.executive->name(i), stats.mean(), stats.max);
+		}
+	}, &driver);
+	driver.executive = &executive;
+	robot::LoopMonitor monitor(executive.period() * 1000); // jitter and overruns of the tick itself, in us
+	driver.monitor = &monitor;
+	driver.tasks = &tasks;
+
+	if (robot::trace::enabled) { // low priority task that moves the timeline to the sd card
+		pros::Task trace_writer([] {
+			tasks.join("trace", TASK_STACK_DEPTH_DEFAULT, 0);
+			FILE* file = fopen("/usd/trace.bin", "wb");
+			if (file == NULL) return;
+			while (true) {
+				robot::trace::flush(file); // flushes the file too, so nothing is lost when the robot is turned off
+				pros::delay(50);
+			}
+		}, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "trace");
+	}
+
+	std::uint32_t now = pros::millis();
+	robot::ArmTask::get().join(tasks); // the arm's own control task, at the top of the table
+	tasks.start(); // before alloc::start(), setting it up allocates
+	robot::alloc::start(); // everything is set up, the loop shouldnt allocate from here on
+	while (true) { // forever loop that runs whichever subsystems are due each tick
+		const std::uint64_t started = pros::micros();
+		monitor.begin(started);
+		ROBOT_TRACE_BEGIN("tick");
+		executive.tick(now);
+		ROBOT_TRACE_END("tick");
+		const std::uint64_t finished = pros::micros();
+		monitor.end(finished);
+		tasks.ran(slot, finished - started);
+		pros::Task::delay_until(&now, executive.period()); // wait until the next tick, without drifting
+	}
+}
 
 /**
  * Runs the operator control code. This function will be started in its own task
@@ -56,93 +284,5 @@ void autonomous() {}
  * task, not resume it from where it left off.
  */
 void opcontrol() {
-	pros::Controller master(pros::E_CONTROLLER_MASTER); // the object for the controller to get inputs
-	pros::MotorGroup left_mg({1, -2, 3});    // Creates a motor group with forwards ports 1 & 3 and reversed port 2
-	pros::MotorGroup right_mg({-4, 5, -6});  // Creates a motor group with forwards port 5 and reversed ports 4 & 6
-	pros::Motor conveyor(-10); // motor for the conveyor belt
-    pros::adi::DigitalOut clamp(1); // pneumatics solenoid controlling the clamp
-    pros::Motor arm(9); // motor for the arm (lady brown mech)
-    pros::Rotation rotation(7); // rotation sensor to get location of the arm
-    pros::Optical color(16); // color sensor, ended up not using it but the light looks cool so its still in the code
-
-    color.set_led_pwm(100); // turn on the color sensor light
-
-    rotation.reset_position(); // reset rotation sensor position to 0 to make everything relative to starting position
-    const int ideal_angle = 1500; // 15 degrees
-
-	bool conveyorMoving = false; // variable to track if the conveyor is actively moving. used for checks when no button is pressed but power draw is low
-    bool clamped = false; // variable to track if the clamp is currently down. used to allow both actions to be mapped to 1 button
-	bool last_clamped = false; // variable to track if the clamp was activated or deactivated on the last cycle. used to prevent the clamp going up and down too quickly on accident
-
-	while (true) { // forever loop that does a cycle each 20ms and updates each cycle
-		pros::lcd::print(0, "left %d right %d", master.get_analog(ANALOG_LEFT_Y), master.get_analog(ANALOG_RIGHT_X));  // prints the status of the joysticks
-		pros::lcd::print(1, "rotational %d", rotation.get_position()); // prints the current rotation according to the rotation sensor for debugging purposes
-
-		// Arcade control scheme
-		int dir = master.get_analog(ANALOG_LEFT_Y) * -1;    // Gets amount forward/backward from left joystick
-		int turn = master.get_analog(ANALOG_RIGHT_X);  // Gets the turn left/right from right joystick
-		left_mg.move(dir - turn);                      // Sets left motor voltage
-		right_mg.move(dir + turn);                     // Sets right motor voltage
-
-        // checks if buttons a, b, r1, or l1 are being pressed and stores them in corresponding variables
-		int a = master.get_digital(DIGITAL_A); // start button
-		int b = master.get_digital(DIGITAL_B); // stop button
-		int r1 = master.get_digital(DIGITAL_R1); // slow move button
-		int l1 = master.get_digital(DIGITAL_L1); // slow reverse button
-        // control flow logic for different controls regarding the conveyor
-		if (b == 1 && conveyor.get_power() > 0.1) { // if the b button is pressed and the conveyor is being powered NOTE: THIS TAKES MASSIVE PRIORITY OVER ALL CONTROLS
-			conveyor.brake(); // then brake the conveyor motor
-			conveyorMoving = false; // and update variables
-		} else if (a == 1) { // or if the a button is pressed
-			conveyor.move(127); // begin moving the conveyor at full speed
-			conveyorMoving = true; // and update variables
-		} else if (r1 == 1) { // or if the r1 button is pressed
-			conveyor.move_voltage(9000); // move at 9v out of 12v to be at a slower pace for fixing issues mid run
-			conveyorMoving = false; // and update variables
-		} else if (l1 == 1) { // or if l1 is pressed
-			conveyor.move_voltage(-9000); // move reverse at 9v out of 12v to fix issues mid run
-			conveyorMoving = false; // and update variables
-		} else if (abs(conveyor.get_current_draw()) <= 5000 && !conveyorMoving) { // and finally if the conveyor power draw is lower than 5v and the conveyor isnt supposed to be moving
-			conveyor.brake(); // then brake the conveyor motor
-            // note this is mainly to prevent issues with the conveyor not stopping after l1 or r1 is pressed or not stopping for the main a button
-		}
-
-        // checks if the x button is pressed
-        int x = master.get_digital(DIGITAL_X); // clamp interact button
-        if (x == 1) { // if x is pressed
-          	// enter another logic flow
-			if (last_clamped) {} /* prevent flow from continuing if it x was pressed last cycle */ else if (clamped) { // if it is already clamped
-            	clamp.set_value(false); // unclamp it
-                clamped = false; // and update variables
-            } else { // if it isn't already clamped
-            	clamp.set_value(true); // clamp it
-                clamped = true; // and update variables
-            }
-			last_clamped = true; // update variables at end to say x was pressed this (which will be last) cycle
-        } else { // or if x isn't pressed
-			last_clamped = false; // update variables to reflect this for next cycle
-		}
-
-        // checks if y, l2, or r2 are pressed
-        int y = master.get_digital(DIGITAL_Y); // prime button
-        int l2 = master.get_digital(DIGITAL_L2); // reverse button
-        int r2 = master.get_digital(DIGITAL_R2); // forward button
-        if (y == 1) { // if y is pressed
-			const int current_angle = rotation.get_position(); // get the current angle of the arm
-			if (current_angle != ideal_angle) { // and check to make sure it is not already at the ideal angle (not possible btw)
-				arm.move_relative(ideal_angle + current_angle, 100); // and then move it the proper relative angle to move toward the ideal angle set earlier
-			}
-        } else if (l2 == 1) { // or if l2 is pressed
-			arm.move(-30); // reverse the arm at 30/127 speed
-        } else if (r2 == 1) { // or if r2 is pressed
-			arm.move(30); // move the arm forward at 30/127 speed
-        } else { // if none are pressed
-			arm.move(0); // stop the arm from moving
-			arm.set_brake_mode(pros::E_MOTOR_BRAKE_HOLD); // set the brake mode to hold
-			arm.brake(); // and brake
-            // the holding brakes should prevent the arm from falling from the force of gravity if in the air
-		}
-
-		pros::delay(20);                               // Run for 20 ms then update
-	}
-}
\ No newline at end of file
+	drive(tasks.join("opcontrol", TASK_STACK_DEPTH_DEFAULT, robot::RobotConfig::loop_period)); // before drive() takes up any stack, see TaskProfiler::join
+}
@@ -0,0 +1,58 @@
+/**
+ * Swings a simulated arm 120 degrees with ArmController, once following the
+ * configuration's motion profile and once with the PID stepped straight to
+ * the target, and prints how long each took to settle and how far it
+ * overshot.
+ *
+ * The arm is a plain second order model: the motor's voltage less what holds
+ * it against gravity and a viscous loss sets the acceleration. It is not the
+ * real arm, only enough of one to compare the two ways of getting there.
+ *
+ *   make host && ./bin/host/arm_sim
+ */
+
+#include "robot/arm_controller.hpp"
+#include "robot/config.hpp"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const int swing = 12000; // centidegrees, from level to over the wall stake
+const int cycles = 600; // of arm_period, three seconds
+
+void run(const char* name, robot::ArmGains gains) {
+	robot::ArmController controller(gains);
+	controller.set_target(gains.horizontal + swing);
+
+	double angle = gains.horizontal, rate = 0; // centidegrees, centidegrees per second
+	double peak = angle;
+	int settled_at = -1; // ms
+	const double dt = robot::RobotConfig::arm_period / 1000.0;
+	for (int i = 0; i < cycles; i++) {
+		const std::uint32_t time = i * robot::RobotConfig::arm_period;
+		const int voltage = controller.update((int) angle, time * 1000ull);
+		const double gravity = gains.kg * std::cos((angle - gains.horizontal) * M_PI / 18000);
+		const double accel = 50 * (voltage - gravity - 0.4 * rate);
+		rate += accel * dt;
+		angle += rate * dt;
+		if (angle > peak) peak = angle;
+		if (controller.settled() && settled_at < 0) settled_at = time;
+	}
+	printf("%-9s settled in %5d ms, overshot %.2f degrees\n", name, settled_at, (peak - gains.horizontal - swing) / 100);
+}
+
+}  // namespace
+
+int main() {
+	robot::ArmGains gains = robot::arm_gains<robot::RobotConfig>();
+	run("profiled", gains);
+
+	// a profile too fast to limit anything, with nothing feeding it forward, is a plain PID
+	gains.max_velocity = 1e9;
+	gains.max_acceleration = 1e12;
+	gains.kv = 0;
+	gains.ka = 0;
+	run("step", gains);
+	return 0;
+}
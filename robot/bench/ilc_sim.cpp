@@ -0,0 +1,75 @@
+/**
+ * Runs the replay's iterative learning against a simple drivetrain and arm
+ * model and prints the RMS tracking error of every replay, so the learning
+ * gains can be checked for converging before they go on the robot.
+ *
+ * The recording is made on one robot and replayed on a slightly different
+ * one: the battery is lower, the right side drags more and the arm lags more,
+ * so the raw commands alone don't reproduce it. Each side's velocity follows
+ * its power with a first order lag and a dead time, less friction, and the arm
+ * closes on its target the same way.
+ *
+ *   make host && ./bin/host/ilc_sim
+ */
+
+#include "robot/ilc.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const std::uint32_t period = 10; // ms, RobotConfig::loop_period
+const int frames = 1500; // 15 s of autonomous
+
+struct Plant {
+	double rpm_per_power; // at full battery a side reaches 600 rpm at 127
+	double left_friction, right_friction; // power lost to drag
+	double lag; // s, time constant of the drive's velocity
+	std::size_t dead_frames; // frames between a command and it starting to show
+	double arm_rate; // of the remaining distance the arm covers per second
+};
+
+// the drive and arm velocities and arm angles a plant measures for a command stream, like /usd/measured.txt
+std::vector<robot::ilc::Frame> run(const Plant& plant, const std::vector<robot::ilc::Frame>& commands) {
+	std::vector<robot::ilc::Frame> measured;
+	double left = 0, right = 0, arm = 0;
+	const double dt = period / 1000.0;
+	const double follow = dt / (plant.lag + dt);
+	for (std::size_t t = 0; t < commands.size(); t++) {
+		const robot::ilc::Frame& command = commands[t < plant.dead_frames ? 0 : t - plant.dead_frames];
+		auto drag = [](int power, double friction) { return power > 0 ? std::max(power - friction, 0.0) : std::min(power + friction, 0.0); };
+		left += (drag(command.left, plant.left_friction) * plant.rpm_per_power - left) * follow;
+		right += (drag(command.right, plant.right_friction) * plant.rpm_per_power - right) * follow;
+		arm += (command.arm - arm) * std::min(plant.arm_rate * dt, 1.0);
+		measured.push_back({(int) std::lround(left), (int) std::lround(right), (int) std::lround(arm)});
+	}
+	return measured;
+}
+
+}  // namespace
+
+int main() {
+	// what the driver did: out, a turn, back, with the arm swinging up and down
+	std::vector<robot::ilc::Frame> driven;
+	for (int t = 0; t < frames; t++) {
+		const double s = t * period / 1000.0;
+		const int dir = (int) std::lround(80 * std::sin(s * 0.8));
+		const int turn = s > 5 && s < 7 ? 20 : 0;
+		driven.push_back({std::clamp(dir - turn, -127, 127), std::clamp(dir + turn, -127, 127), s < 8 ? 3000 : 12000});
+	}
+
+	const Plant recorded{600.0 / 127, 5, 5, 0.08, 2, 8};
+	const Plant replayed{0.9 * 600.0 / 127, 6, 12, 0.1, 3, 5};
+	const std::vector<robot::ilc::Frame> reference = run(recorded, driven); // the velocities and angles in the recording
+
+	robot::ilc::Gains gains;
+	gains.period = period;
+	std::vector<robot::ilc::Frame> commands = driven;
+	for (int iteration = 0; iteration <= 8; iteration++) {
+		const robot::ilc::Error error = robot::ilc::update(reference, run(replayed, commands), commands, gains);
+		printf("replay %d: drive rms %5.1f rpm, arm rms %6.1f cdeg\n", iteration, error.drive, error.arm);
+	}
+	return 0;
+}
@@ -0,0 +1,40 @@
+/**
+ * Runs the conveyor through Robot::step at the mechanism rate with made up
+ * motor readings: a normal spin-up, a second of running, then a ring stuck
+ * fast. Prints every conveyor command sent and how long after the stall the
+ * conveyor was reversed. The spin-up must not count as a jam.
+ *
+ *   make host && ./bin/host/jam_sim
+ */
+
+#include "robot/robot.hpp"
+#include <cstdio>
+
+namespace {
+
+const std::uint32_t period = 20; // ms, the mechanism subsystem's rate in driver control
+const std::uint32_t spin_up = 100; // ms the conveyor takes to get going
+const std::uint32_t stall_at = 1000; // ms
+
+}  // namespace
+
+int main() {
+	robot::Robot robot;
+	int reversed_at = -1;
+	for (std::uint32_t time = 0; time < 1600; time += period) {
+		robot::Inputs in;
+		in.time = time;
+		in.a = time < 2 * period; // tap a for full speed
+		in.conveyor_power = 5;
+		const bool stalled = time < spin_up || (time >= stall_at && reversed_at < 0);
+		in.conveyor_current = stalled ? 2500 : 900;
+		in.conveyor_velocity = time < spin_up ? 50 : stalled ? 3 : 580;
+		in.conveyor_torque = stalled ? 0.35 : 0.08;
+
+		const robot::Commands out = robot.step(in);
+		if (out.conveyor.mode != robot::ConveyorCommand::Keep) printf("%5u ms: conveyor mode %d value %d, %u jams\n", time, out.conveyor.mode, out.conveyor.value, robot.conveyor_jams());
+		if (out.conveyor.mode == robot::ConveyorCommand::Voltage && out.conveyor.value < 0 && reversed_at < 0) reversed_at = time;
+	}
+	printf("stalled at %u ms, reversed at %d ms, %d ms later\n", stall_at, reversed_at, reversed_at - (int) stall_at);
+	return 0;
+}
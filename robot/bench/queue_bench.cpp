@@ -0,0 +1,115 @@
+/**
+ * Compares robot::SpscQueue with a queue built like the PROS queue_create /
+ * queue_append path in apix.h. That path is a FreeRTOS queue: items are
+ * memcpy'd into a fixed buffer inside a critical section, and a full or empty
+ * queue blocks the caller. The FreeRTOS kernel doesn't run on Linux, so it is
+ * modelled with a mutex and condition variables, which is the same work a
+ * task does there.
+ *
+ *   make host && ./bin/host/queue_bench
+ */
+
+#include "robot/recording.hpp"
+#include "robot/spsc_queue.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// what the recorder hands its logging task every cycle
+using Item = robot::RecordedCycle;
+
+class RtosQueue {
+public:
+	RtosQueue(std::uint32_t length, std::uint32_t item_size) : storage(length * item_size), length(length), item_size(item_size) {}
+
+	bool append(const void* item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		not_full.wait(lock, [&] { return count < length; });
+		std::memcpy(&storage[((head + count) % length) * item_size], item, item_size);
+		count++;
+		not_empty.notify_one();
+		return true;
+	}
+
+	bool recv(void* item) {
+		std::unique_lock<std::mutex> lock(mutex);
+		not_empty.wait(lock, [&] { return count > 0; });
+		std::memcpy(item, &storage[head * item_size], item_size);
+		head = (head + 1) % length;
+		count--;
+		not_full.notify_one();
+		return true;
+	}
+
+private:
+	std::vector<unsigned char> storage;
+	std::uint32_t length, item_size, head = 0, count = 0;
+	std::mutex mutex;
+	std::condition_variable not_full, not_empty;
+};
+
+template <typename Push, typename Pop>
+double ns_per_item(int items, Push push, Pop pop, bool threaded) {
+	auto start = std::chrono::steady_clock::now();
+	if (threaded) {
+		std::thread consumer([&] {
+			for (int i = 0; i < items; i++) pop();
+		});
+		for (int i = 0; i < items; i++) push(i);
+		consumer.join();
+	} else {
+		for (int i = 0; i < items; i++) {
+			push(i);
+			pop();
+		}
+	}
+	auto end = std::chrono::steady_clock::now();
+	return std::chrono::duration<double, std::nano>(end - start).count() / items;
+}
+
+}  // namespace
+
+int main() {
+	const int items = 2000000;
+	long checksum = 0;
+
+	for (bool threaded : {false, true}) {
+		static robot::SpscQueue<Item, 64> spsc;
+		double spsc_ns = ns_per_item(items,
+			[&](int i) {
+				Item item;
+				item.in.dir = i;
+				while (!spsc.push(item)) std::this_thread::yield();
+			},
+			[&] {
+				Item item;
+				while (!spsc.pop(item)) std::this_thread::yield();
+				checksum += item.in.dir;
+			},
+			threaded);
+
+		RtosQueue rtos(64, sizeof(Item));
+		double rtos_ns = ns_per_item(items,
+			[&](int i) {
+				Item item;
+				item.in.dir = i;
+				rtos.append(&item);
+			},
+			[&] {
+				Item item;
+				rtos.recv(&item);
+				checksum += item.in.dir;
+			},
+			threaded);
+
+		printf("%s: SpscQueue %.1f ns per item, queue_append style %.1f ns per item\n", threaded ? "two threads" : "one thread ", spsc_ns, rtos_ns);
+	}
+	printf("(checksum %ld, item size %zu bytes)\n", checksum, sizeof(Item));
+	return 0;
+}
@@ -0,0 +1,70 @@
+/**
+ * Runs driver control's example autonomous routine through Sequencer and
+ * Robot::step against a rough drivetrain and arm, and counts every heap
+ * allocation made while it runs. Coroutine frames are meant to come from
+ * the sequencer's pool, so the count should be 0 at any optimization level:
+ *
+ *   make host && ./bin/host/sequencer_sim
+ *   make host EXTRA_CXXFLAGS=-O0 && ./bin/host/sequencer_sim
+ *
+ * (after a make clean, so the library is rebuilt too)
+ */
+
+#include "robot/sequencer.hpp"
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+long allocations = 0;
+
+robot::auton::Routine routine() { // the same steps as the example in driver control's autonomous()
+	using namespace robot::auton;
+	co_await drive_to(-900);
+	co_await clamp(true);
+	co_await wait(200);
+	co_await conveyor(127);
+	co_await all(drive_to(0), arm_to(robot::ArmPreset::Load));
+	co_await wait(1500);
+	co_await conveyor(0);
+}
+
+}  // namespace
+
+void* operator new(std::size_t size) {
+	allocations++;
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+int main() {
+	robot::Robot robot;
+	robot::auton::Sequencer sequencer(robot::auton::sequencer_settings<robot::RobotConfig>());
+	double left = 0, right = 0; // degrees
+	int arm = robot::RobotConfig::arm_presets[static_cast<std::size_t>(robot::ArmPreset::Stow)];
+
+	const long before = allocations;
+	sequencer.start(routine());
+	std::uint32_t time = 0;
+	for (; time < 10000 && !sequencer.done(); time += robot::RobotConfig::loop_period) {
+		robot::Inputs in;
+		in.time = time;
+		in.left_position = left;
+		in.right_position = right;
+		in.arm_angle = arm;
+		sequencer.tick(time, in);
+		robot::Commands out = robot.step(in);
+		sequencer.apply(out);
+
+		left += out.left * 0.2; // degrees per cycle at each unit of power, the right side a little stronger
+		right += out.right * 0.21;
+		if (out.arm.mode == robot::ArmCommand::Target) arm += (out.arm.value - arm) / 4; // the arm task closing in
+	}
+
+	printf("routine %s at %u ms, drive at %.0f/%.0f, arm at %d\n", sequencer.done() ? "done" : "still running", time, left, right, arm);
+	printf("%ld heap allocations while it ran\n", allocations - before);
+	return 0;
+}
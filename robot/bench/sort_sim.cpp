@@ -0,0 +1,66 @@
+/**
+ * Runs the conveyor through Robot::step at the mechanism rate with rings of
+ * alternating color coming up it, sorting out blue. The conveyor moves at
+ * full speed whenever it isn't braked, and a ring is in front of the optical
+ * sensor for the first ring_width degrees after it enters. Prints how many
+ * rings of each color were thrown out and the sorter's own line for the
+ * screen.
+ *
+ *   make host && ./bin/host/sort_sim
+ */
+
+#include "robot/robot.hpp"
+#include <cmath>
+#include <cstdio>
+
+namespace {
+
+const std::uint32_t period = 20; // ms, the mechanism subsystem's rate in driver control
+const double speed = 3600; // conveyor encoder degrees per second, 600 rpm
+const double ring_gap = 600; // degrees between rings coming in
+const double ring_width = 150; // degrees of travel a ring spends in front of the sensor
+const double eject_at = robot::RobotConfig::ring_marks[static_cast<std::size_t>(robot::RingMark::Eject)];
+
+bool blue(long ring) { return ring % 2; }
+
+}  // namespace
+
+int main() {
+	robot::Robot robot;
+	robot.sort_out(robot::RingColor::Blue);
+
+	double position = 0;
+	bool braked = false;
+	int thrown[2] = {}; // red, blue
+	for (std::uint32_t time = 0; time < 10000; time += period) {
+		robot::Inputs in;
+		in.time = time;
+		in.a = time < 2 * period; // tap a for full speed
+		in.conveyor_power = 5;
+		in.conveyor_current = 800;
+		in.conveyor_velocity = braked ? 0 : 580;
+		in.conveyor_torque = 0.1;
+		in.conveyor_position = position;
+		const long entering = (long) std::floor(position / ring_gap); // the last ring to come in
+		const bool present = position - entering * ring_gap < ring_width;
+		in.ring_proximity = present ? 200 : 10;
+		in.ring_hue = blue(entering) ? robot::RobotConfig::ring_blue_hue : robot::RobotConfig::ring_red_hue;
+
+		const robot::Commands out = robot.step(in);
+		if (out.conveyor.mode == robot::ConveyorCommand::Brake && !braked) {
+			const long ring = std::lround((position - eject_at) / ring_gap); // the one nearest the eject mark
+			thrown[blue(ring)]++;
+		}
+		if (out.conveyor.mode == robot::ConveyorCommand::Brake) braked = true;
+		else if (out.conveyor.mode == robot::ConveyorCommand::Move) braked = false;
+		if (!braked) position += speed * period / 1000;
+	}
+
+	const long passed = (long) std::floor((position - eject_at) / ring_gap) + 1; // rings that reached the eject mark
+	char line[64];
+	robot.sorting().format(line, sizeof line);
+	printf("%ld rings reached the eject mark, %ld blue\n", passed, passed / 2);
+	printf("threw out %d blue and %d red\n", thrown[1], thrown[0]);
+	printf("%s\n", line);
+	return 0;
+}
@@ -0,0 +1,54 @@
+/**
+ * Measures the per-cycle cost of Robot::step on Linux. Inputs are generated up
+ * front so only the robot logic is timed.
+ *
+ *   make host && ./bin/host/step_bench
+ */
+
+#include "robot/robot.hpp"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+int main() {
+	const int cycles = 1000000;
+
+	std::mt19937 rng(1234);
+	std::uniform_int_distribution<int> stick(-127, 127);
+	std::uniform_int_distribution<int> button(0, 7); // each button held about an eighth of the time
+	std::vector<robot::Inputs> inputs(4096);
+	for (robot::Inputs& in : inputs) {
+		in.dir = stick(rng);
+		in.turn = stick(rng);
+		in.a = button(rng) == 0;
+		in.b = button(rng) == 0;
+		in.r1 = button(rng) == 0;
+		in.l1 = button(rng) == 0;
+		in.x = button(rng) == 0;
+		in.y = button(rng) == 0;
+		in.arm_preset = button(rng) == 0 ? button(rng) % static_cast<int>(robot::ArmPreset::Count) : -1;
+		in.l2 = button(rng) == 0;
+		in.r2 = button(rng) == 0;
+		in.conveyor_power = button(rng) * 0.5;
+		in.conveyor_current = stick(rng) * 50;
+		in.arm_angle = stick(rng) * 20;
+		in.left_current = stick(rng) * 20;
+		in.right_current = stick(rng) * 20;
+	}
+
+	robot::Robot robot;
+	long checksum = 0; // keeps the compiler from throwing the loop away
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < cycles; i++) {
+		robot::Inputs in = inputs[i % inputs.size()];
+		in.time = i * robot::RobotConfig::loop_period; // the inputs repeat but time keeps going, like on the robot
+		robot::Commands out = robot.step(in);
+		checksum += out.left + out.right + out.conveyor.value + out.arm.value + out.clamp;
+	}
+	auto end = std::chrono::steady_clock::now();
+
+	double ns = std::chrono::duration<double, std::nano>(end - start).count() / cycles;
+	printf("Robot::step: %.1f ns per cycle (checksum %ld)\n", ns, checksum);
+	return 0;
+}
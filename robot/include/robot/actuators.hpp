@@ -0,0 +1,131 @@
+/**
+ * \file actuators.hpp
+ *
+ * Wrappers around pros::Motor, pros::MotorGroup and pros::adi::DigitalOut that
+ * remember the last command sent and skip sending it again.
+ *
+ * The control logic states what every device should be doing on every cycle,
+ * which is mostly the same thing as last cycle. The kernel keeps driving the
+ * last target it was given, so repeats are only wasted smart port and ADI
+ * writes. Each skipped write is counted in a WriteCounter so the savings can be
+ * shown on the screen.
+ */
+
+#ifndef _ROBOT_ACTUATORS_HPP_
+#define _ROBOT_ACTUATORS_HPP_
+
+#include "api.h"
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * Writes sent and skipped, shared by every actuator of one Devices.
+ */
+struct WriteCounter {
+	std::uint32_t sent = 0;
+	std::uint32_t suppressed = 0;
+
+	void reset() { sent = suppressed = 0; }
+};
+
+/**
+ * A motor or motor group that only sends a command when it differs from the
+ * last one. Relative moves always go through since each one moves further.
+ */
+template <typename MotorType>
+class CachedMotor {
+public:
+	template <typename... Args>
+	CachedMotor(WriteCounter& counter, Args&&... args) : counter(counter), motor(args...) {}
+
+	void move(int power) { send(Move, power, [&] { motor.move(power); }); }
+
+	void move_voltage(int millivolts) { send(Voltage, millivolts, [&] { motor.move_voltage(millivolts); }); }
+
+	void brake() { send(Brake, 0, [&] { motor.brake(); }); }
+
+	void move_relative(double position, int velocity) {
+		motor.move_relative(position, velocity);
+		counter.sent++;
+		last = Relative;
+	}
+
+	void set_brake_mode(pros::motor_brake_mode_e_t mode) {
+		if (brake_mode == mode) {
+			counter.suppressed++;
+			return;
+		}
+		motor.set_brake_mode(mode);
+		counter.sent++;
+		brake_mode = mode;
+	}
+
+	/**
+	 * Forgets the cached state so the next command is always sent, e.g. after
+	 * the motor was unplugged and lost its target.
+	 */
+	void invalidate() {
+		last = None;
+		brake_mode = pros::E_MOTOR_BRAKE_INVALID;
+	}
+
+	/**
+	 * The wrapped device, for sensor reads. Commands sent through it bypass the
+	 * cache, so call invalidate() after doing that.
+	 */
+	MotorType& device() { return motor; }
+	const MotorType& device() const { return motor; }
+
+private:
+	enum Kind : std::uint8_t { None, Move, Voltage, Brake, Relative };
+
+	template <typename Write>
+	void send(Kind kind, int value, Write write) {
+		if (last == kind && last_value == value) {
+			counter.suppressed++;
+			return;
+		}
+		write();
+		counter.sent++;
+		last = kind;
+		last_value = value;
+	}
+
+	WriteCounter& counter;
+	MotorType motor;
+	Kind last = None;
+	int last_value = 0;
+	pros::motor_brake_mode_e_t brake_mode = pros::E_MOTOR_BRAKE_INVALID;
+};
+
+/**
+ * An ADI digital output that only writes when the value changes.
+ */
+class CachedDigitalOut {
+public:
+	CachedDigitalOut(WriteCounter& counter, std::uint8_t port) : counter(counter), out(port) {}
+
+	void set_value(bool value) {
+		if (written && value == last) {
+			counter.suppressed++;
+			return;
+		}
+		out.set_value(value);
+		counter.sent++;
+		written = true;
+		last = value;
+	}
+
+	void invalidate() { written = false; }
+
+private:
+	WriteCounter& counter;
+	pros::adi::DigitalOut out;
+	bool written = false;
+	bool last = false;
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_ACTUATORS_HPP_
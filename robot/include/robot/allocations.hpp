@@ -0,0 +1,83 @@
+/**
+ * \file allocations.hpp
+ *
+ * Counts heap allocations, to check the control loops never allocate once
+ * they are running.
+ *
+ * Build a program with `make clean && make ALLOC_TRACE=1` to turn it on. That
+ * links it as one image instead of hot/cold, because the C library has to be
+ * part of the link for its allocator to be wrapped. It wraps newlib's
+ * _malloc_r, _realloc_r and _free_r, so malloc, new, strdup and stdio buffers
+ * are all seen. It also defines ROBOT_ALLOC_TRACE. Without it every function
+ * here is an empty inline, and none of allocations.cpp gets linked.
+ *
+ * Every allocation is counted against the task that made it and the phase
+ * that task last named with phase(). Allocations between start() and stop()
+ * are also counted as late, and the first late one is remembered so it can
+ * be found.
+ */
+
+#ifndef _ROBOT_ALLOCATIONS_HPP_
+#define _ROBOT_ALLOCATIONS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace robot::alloc {
+
+/**
+ * Names the task that is running, e.g.
+ * []() -> const char* { return pros::c::task_get_name(NULL); }
+ * It is called on every allocation, so it must not allocate itself.
+ */
+using TaskName = const char* (*)();
+
+#ifdef ROBOT_ALLOC_TRACE
+
+constexpr bool enabled = true;
+
+void init(TaskName current);
+
+/**
+ * Counts the current task's allocations under name until it names another
+ * phase. name has to outlive the program, a string literal.
+ */
+void phase(const char* name);
+
+void start();
+void stop();
+
+/**
+ * Allocations made between start() and stop().
+ */
+std::uint32_t late();
+
+/**
+ * A one line description of the late allocations for the brain screen, e.g.
+ * "late allocs 3, first 24 B control/sample".
+ */
+int format_late(char* buffer, std::size_t size);
+
+/**
+ * Writes the counts of every task and phase as text.
+ */
+void dump(FILE* file);
+
+#else
+
+constexpr bool enabled = false;
+
+inline void init(TaskName) {}
+inline void phase(const char*) {}
+inline void start() {}
+inline void stop() {}
+inline std::uint32_t late() { return 0; }
+inline int format_late(char* buffer, std::size_t size) { return size ? (buffer[0] = '\0', 0) : 0; }
+inline void dump(FILE*) {}
+
+#endif
+
+}  // namespace robot::alloc
+
+#endif  // _ROBOT_ALLOCATIONS_HPP_
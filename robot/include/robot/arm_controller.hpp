@@ -0,0 +1,122 @@
+/**
+ * \file arm_controller.hpp
+ *
+ * Closed loop position control of the arm on the rotation sensor.
+ *
+ * A new target doesn't go straight to the PID. It becomes a trapezoidal
+ * motion profile (motion_profile.hpp) from wherever the arm is, at the arm's
+ * speed and acceleration limits, and every update follows the profile's
+ * setpoint for that moment. Velocity and acceleration feedforward do most of
+ * the work of following it, plus a gravity feedforward that is largest with
+ * the arm level and nothing with it straight up or down, so the PID only
+ * corrects what those don't explain. Big swings go at full speed and still
+ * stop without overshooting. The output is in millivolts for move_voltage.
+ * arm_task.hpp runs it on its own task on the brain.
+ */
+
+#ifndef _ROBOT_ARM_CONTROLLER_HPP_
+#define _ROBOT_ARM_CONTROLLER_HPP_
+
+#include "robot/motion_profile.hpp"
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * Arm tuning, usually arm_gains() of the robot configuration. Angles are
+ * rotation sensor centidegrees.
+ */
+struct ArmGains {
+	double kp; // mV per centidegree of error
+	double ki; // mV per centidegree second
+	double kd; // mV per centidegree per second behind the profile's speed
+	double kv; // mV per centidegree per second the profile asks for
+	double ka; // mV per centidegree per second squared the profile asks for
+	double kg; // mV that holds the arm level
+	int horizontal; // rotation reading with the arm level
+	double max_velocity; // centidegrees per second
+	double max_acceleration; // centidegrees per second squared
+	double integral_limit; // most mV the integral can add
+	int tolerance; // close enough to the target
+	std::uint32_t settle_time; // ms inside tolerance before it counts as settled
+};
+
+/**
+ * The arm tuning in a robot configuration.
+ */
+template <typename Config>
+constexpr ArmGains arm_gains() {
+	ArmGains settings;
+	settings.kp = Config::arm_kp;
+	settings.ki = Config::arm_ki;
+	settings.kd = Config::arm_kd;
+	settings.kv = Config::arm_kv;
+	settings.ka = Config::arm_ka;
+	settings.kg = Config::arm_kg;
+	settings.horizontal = Config::arm_horizontal;
+	settings.max_velocity = Config::arm_max_velocity;
+	settings.max_acceleration = Config::arm_max_acceleration;
+	settings.integral_limit = Config::arm_integral_limit;
+	settings.tolerance = Config::arm_tolerance;
+	settings.settle_time = Config::arm_settle_time;
+	return settings;
+}
+
+class ArmController {
+public:
+	static constexpr int max_voltage = 12000; // mV
+
+	explicit ArmController(ArmGains gains) : gains(gains) {}
+
+	/**
+	 * Starts moving to angle. Returns straight away; the profile is planned on
+	 * the next update(), from the angle the arm is at then. The same target
+	 * again changes nothing.
+	 */
+	void set_target(int angle);
+
+	/**
+	 * Stops controlling, e.g. while the driver moves the arm by hand.
+	 */
+	void release() { active = false; }
+
+	bool has_target() const { return active; }
+	int target() const { return target_angle; }
+
+	/**
+	 * One control cycle at time us with the arm at angle. Returns the voltage
+	 * to send, 0 without a target.
+	 */
+	int update(int angle, std::uint64_t time);
+
+	/**
+	 * Whether the profile has finished and the arm has stayed within tolerance
+	 * of the target for the settle time since.
+	 */
+	bool settled() const { return active && is_settled; }
+
+	/**
+	 * Where the profile wants the arm as of the last update.
+	 */
+	const Setpoint& setpoint() const { return current; }
+
+private:
+	ArmGains gains;
+	bool active = false;
+	int target_angle = 0;
+	bool started = false; // whether last_angle and last_time hold a reading yet
+	int last_angle = 0;
+	std::uint64_t last_time = 0;
+	bool planned = false; // whether profile is for the current target yet
+	TrapezoidProfile profile;
+	std::uint64_t profile_start = 0; // us
+	Setpoint current{0, 0, 0};
+	double integral = 0; // centidegree seconds
+	bool in_tolerance = false;
+	std::uint64_t entered = 0; // us, when the arm last came within tolerance
+	bool is_settled = false;
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_ARM_CONTROLLER_HPP_
@@ -0,0 +1,139 @@
+/**
+ * \file arm_task.hpp
+ *
+ * Runs the arm controller from arm_controller.hpp on its own task every
+ * arm_period ms, reading the rotation sensor directly.
+ *
+ * The control loop hands it each cycle's ArmCommand with command(), which only
+ * stores it and returns. The task is the only thing that writes to the arm
+ * motor: it follows a Target with the controller and passes Move and Hold
+ * straight on. There is one per program, started by the first command. It
+ * outlives the competition task that started it, so a mode change that kills
+ * that task leaves the arm held where it was rather than dropping it.
+ */
+
+#ifndef _ROBOT_ARM_TASK_HPP_
+#define _ROBOT_ARM_TASK_HPP_
+
+#include "api.h"
+#include "robot/actuators.hpp"
+#include "robot/arm_controller.hpp"
+#include "robot/robot.hpp"
+#include "robot/task_profiler.hpp"
+#include "robot/trace.hpp"
+#include <atomic>
+
+namespace robot {
+
+template <typename Config>
+class BasicArmTask {
+public:
+	/**
+	 * The program's arm task, started on the first call.
+	 */
+	static BasicArmTask& get() {
+		static BasicArmTask arm;
+		return arm;
+	}
+
+	/**
+	 * What the arm should do from its next update on. Keep changes nothing.
+	 * Never blocks.
+	 */
+	void command(const ArmCommand& command) {
+		if (command.mode == ArmCommand::Keep) return;
+		request = (std::uint64_t) command.mode << 32 | (std::uint32_t) command.value;
+	}
+
+	/**
+	 * Whether the arm has reached its target and stayed there for the settle
+	 * time.
+	 */
+	bool settled() const { return is_settled; }
+
+	/**
+	 * Has the arm task join profiler before its next update and report every
+	 * update to it from then on. The task joins itself, as join() requires.
+	 */
+	void join(TaskProfiler& profiler) { joining = &profiler; }
+
+	/**
+	 * Has the arm task resend its next command even if it matches the last
+	 * one, for the start of a mode. Never blocks.
+	 */
+	void invalidate() { stale = true; }
+
+	WriteCounter writes; // the arm motor's own, since this task writes it. Never reset, readers keep the last counts and subtract
+
+private:
+	BasicArmTask() = default;
+
+	void run() {
+		std::uint32_t now = pros::millis();
+		TaskProfiler* profiler = nullptr;
+		int slot = -1;
+		while (true) {
+			if (TaskProfiler* joined = joining.exchange(nullptr)) {
+				profiler = joined;
+				slot = profiler->join("arm", TASK_STACK_DEPTH_DEFAULT, Config::arm_period);
+			}
+			const std::uint64_t started = pros::micros();
+			update();
+			if (profiler) profiler->ran(slot, pros::micros() - started);
+			pros::Task::delay_until(&now, Config::arm_period);
+		}
+	}
+
+	void update() {
+		ROBOT_TRACE_SCOPE("arm control");
+		const bool installed = motor.device().is_installed(); // the registry's view of the port, no smart port traffic
+		if (stale.exchange(false) || (installed && !motor_installed)) motor.invalidate(); // a motor plugged back in lost its target
+		motor_installed = installed;
+		const std::uint64_t packed = request;
+		const ArmCommand command{(ArmCommand::Mode) (packed >> 32), (int) (std::uint32_t) packed};
+		switch (command.mode) {
+			case ArmCommand::Keep: break; // nothing asked for yet
+			case ArmCommand::Hold:
+				controller.release();
+				hold();
+				break;
+			case ArmCommand::Move:
+				controller.release();
+				motor.move(command.value);
+				break;
+			case ArmCommand::Target: {
+				const std::int32_t angle = rotation.get_position();
+				if (angle == PROS_ERR) { // unplugged sensor, dont chase a garbage angle
+					controller.release();
+					hold();
+					break;
+				}
+				controller.set_target(command.value);
+				motor.move_voltage(controller.update(angle, pros::micros()));
+				break;
+			}
+		}
+		is_settled = controller.settled();
+	}
+
+	void hold() { // holding brakes keep the arm from falling when it is in the air
+		motor.set_brake_mode(pros::E_MOTOR_BRAKE_HOLD);
+		motor.brake();
+	}
+
+	std::atomic<std::uint64_t> request{(std::uint64_t) ArmCommand::Keep << 32}; // mode in the top half, value in the bottom
+	std::atomic<bool> is_settled{false};
+	std::atomic<TaskProfiler*> joining{nullptr}; // handed over by join(), picked up by the task
+	std::atomic<bool> stale{false}; // set by invalidate(), the task clears the motor's cache
+	bool motor_installed = true; // whether the last update found the arm motor plugged in
+	ArmController controller{arm_gains<Config>()};
+	CachedMotor<pros::Motor> motor{writes, Config::arm}; // motor for the arm (lady brown mech)
+	pros::Rotation rotation{Config::rotation}; // the same sensor Devices reads, its own object so nothing is shared between tasks
+	pros::Task task{[this] { run(); }, TASK_PRIORITY_DEFAULT + 1, TASK_STACK_DEPTH_DEFAULT, "arm"}; // last, so everything it uses exists before it starts
+};
+
+using ArmTask = BasicArmTask<RobotConfig>;
+
+}  // namespace robot
+
+#endif  // _ROBOT_ARM_TASK_HPP_
@@ -0,0 +1,77 @@
+/**
+ * \file buttons.hpp
+ *
+ * Turns button levels into debounced press, release, hold and double tap
+ * events, each stamped with the time it happened.
+ *
+ * ButtonTracker only looks at the button levels and the time it is given, so
+ * feeding it the same recorded levels at the same times gives the same
+ * events. A replay therefore toggles the clamp on exactly the cycle the
+ * driver did. sample() reads only get_digital, one read per button per
+ * cycle, and the edges come from here. A tap would have to be shorter than
+ * one loop period to fall between two samples.
+ */
+
+#ifndef _ROBOT_BUTTONS_HPP_
+#define _ROBOT_BUTTONS_HPP_
+
+#include "robot/snapshot.hpp"
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * The events of one update, one bit per Button in each mask.
+ */
+struct ButtonEvents {
+	std::uint32_t time = 0; // ms, when these happened
+	std::uint16_t pressed = 0;
+	std::uint16_t released = 0;
+	std::uint16_t held = 0; // held down for hold_time, fires once per press
+	std::uint16_t double_tapped = 0; // pressed again within double_tap_time of the last press, also sets pressed
+
+	static constexpr std::uint16_t bit(Button button) { return 1u << static_cast<unsigned>(button); }
+	bool was_pressed(Button button) const { return pressed & bit(button); }
+	bool was_released(Button button) const { return released & bit(button); }
+	bool was_held(Button button) const { return held & bit(button); }
+	bool was_double_tapped(Button button) const { return double_tapped & bit(button); }
+};
+
+class ButtonTracker {
+public:
+	struct Settings {
+		std::uint32_t debounce_time = 30; // ms, a level change this soon after the last one is ignored
+		std::uint32_t hold_time = 400; // ms
+		std::uint32_t double_tap_time = 300; // ms
+	};
+
+	ButtonTracker() = default;
+	explicit ButtonTracker(const Settings& settings) : settings(settings) {}
+
+	/**
+	 * Compares levels (Snapshot::buttons) with the debounced state and reports
+	 * what changed at time now (ms). Call it once per cycle, with non
+	 * decreasing times.
+	 */
+	ButtonEvents update(std::uint16_t levels, std::uint32_t now);
+
+	/**
+	 * The debounced levels.
+	 */
+	std::uint16_t levels() const { return state; }
+
+private:
+	static constexpr unsigned count = static_cast<unsigned>(Button::Count);
+
+	Settings settings;
+	std::uint16_t state = 0;
+	bool started = false;
+	std::uint32_t changed_at[count] = {}; // last accepted level change
+	std::uint32_t pressed_at[count] = {};
+	bool tapped[count] = {}; // pressed at least once, so pressed_at is meaningful
+	std::uint16_t hold_reported = 0;
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_BUTTONS_HPP_
@@ -0,0 +1,91 @@
+/**
+ * \file color_sort.hpp
+ *
+ * Throws out rings of the other alliance's color.
+ *
+ * The ring tracker reads each ring's color as it passes the optical sensor at
+ * the bottom of the conveyor and follows it up on the encoder. When a ring of
+ * the rejected color gets to the eject mark (less sort_lead, for the sensing
+ * and motor delay), the sorter stops the conveyor for sort_fling_time so the
+ * ring's momentum carries it off the hooks, then the conveyor carries on.
+ *
+ * Every ring thrown out adds to two histograms: the time from its color being
+ * read to the conveyor stopping, and how far past the eject mark the belt was
+ * by then, which is what sort_lead gets tuned with. Nothing in here touches
+ * PROS.
+ */
+
+#ifndef _ROBOT_COLOR_SORT_HPP_
+#define _ROBOT_COLOR_SORT_HPP_
+
+#include "robot/loop_monitor.hpp"
+#include "robot/ring_tracker.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+
+struct SortSettings {
+	double eject_at; // conveyor encoder degrees from the sensor
+	double lead; // degrees
+	std::uint32_t fling_time; // ms
+};
+
+/**
+ * The color sorter settings in a robot configuration.
+ */
+template <typename Config>
+constexpr SortSettings sort_settings() {
+	SortSettings settings;
+	settings.eject_at = Config::ring_marks[static_cast<std::size_t>(RingMark::Eject)];
+	settings.lead = Config::sort_lead;
+	settings.fling_time = Config::sort_fling_time;
+	return settings;
+}
+
+class ColorSorter {
+public:
+	explicit ColorSorter(SortSettings settings) : settings(settings) {}
+
+	/**
+	 * Which color to throw out, None to keep everything.
+	 */
+	void reject(RingColor color) { rejected_color = color; }
+	RingColor rejected() const { return rejected_color; }
+
+	/**
+	 * One cycle at time ms. running is whether the conveyor is going forward.
+	 * Returns true while it should be stopped to fling a ring.
+	 */
+	bool update(std::uint32_t time, const RingTracker& rings, bool running);
+
+	/**
+	 * Whether the last update ended a fling, so the forward command has to be
+	 * sent again.
+	 */
+	bool resumed() const { return just_resumed; }
+
+	std::uint32_t ejected() const { return count; }
+	const Histogram& latency() const { return latency_ms; } // ms from reading the color to stopping
+	const Histogram& error() const { return error_degrees; } // degrees past the eject mark when it stopped, negative if early
+
+	/**
+	 * A line for the screen, e.g. "sorted 3 in 410/452/480 ms late 12".
+	 */
+	int format(char* buffer, std::size_t size) const;
+
+private:
+	SortSettings settings;
+	RingColor rejected_color = RingColor::None;
+	std::uint32_t handled = 0; // id of the last ring thrown out or let through
+	bool flinging = false;
+	std::uint32_t fling_started = 0;
+	bool just_resumed = false;
+	std::uint32_t count = 0;
+	Histogram latency_ms{0, 50};
+	Histogram error_degrees{-80, 10};
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_COLOR_SORT_HPP_
@@ -0,0 +1,140 @@
+/**
+ * \file config.hpp
+ *
+ * The robot's ports, reversals and tuning constants, in one place.
+ *
+ * Robot and Devices are templated on a configuration struct like HighStakes
+ * below, so every port and constant is a compile time value folded straight
+ * into the control loop. check_config runs at compile time and rejects a
+ * configuration with out of range or doubled up ports.
+ *
+ * Every time constant is in ms, never in cycles, so changing loop_period
+ * doesn't change how the robot behaves in time.
+ */
+
+#ifndef _ROBOT_CONFIG_HPP_
+#define _ROBOT_CONFIG_HPP_
+
+#include <array>
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * The high stakes robot. A negative smart port means the motor is reversed.
+ */
+struct HighStakes {
+	static constexpr std::array<std::int8_t, 3> left_drive = {1, -2, 3}; // forwards ports 1 & 3 and reversed port 2
+	static constexpr std::array<std::int8_t, 3> right_drive = {-4, 5, -6}; // forwards port 5 and reversed ports 4 & 6
+	static constexpr std::int8_t conveyor = -10; // motor for the conveyor belt
+	static constexpr std::int8_t arm = 9; // motor for the arm (lady brown mech)
+	static constexpr std::uint8_t rotation = 7; // rotation sensor on the arm
+	static constexpr std::uint8_t color = 16; // optical sensor at the bottom of the conveyor
+	static constexpr std::uint8_t imu = 11; // inertial sensor, for holding the heading while driving straight
+	static constexpr std::uint8_t clamp = 1; // ADI port of the clamp solenoid
+
+	static constexpr std::uint32_t loop_period = 10; // ms between control cycles and recorded lines, 5, 10 or 20
+	static constexpr std::uint32_t recording_length = 60000; // ms, how long the recorder runs
+
+	static constexpr int color_led_pwm = 100; // percent brightness of the optical sensor light
+	static constexpr double color_integration_time = 3; // ms, the optical sensor's shortest, it still only reports every 20 ms
+
+	static constexpr int conveyor_power = 127; // a, full speed
+	static constexpr int conveyor_slow_voltage = 9000; // mV, r1/l1 for fixing issues mid run
+	static constexpr double conveyor_moving_power = 0.1; // W, above this b counts as stopping a running conveyor
+	static constexpr int conveyor_idle_current = 5000; // mA, at or below this an idle conveyor gets braked
+	static constexpr double jam_current = 2000; // mA, a jammed conveyor draws at least this
+	static constexpr double jam_velocity = 60; // rpm, and turns at most this fast
+	static constexpr double jam_torque = 0.2; // Nm, and makes at least this much torque
+	static constexpr std::uint32_t jam_filter_time = 15; // ms, time constant of the jam detector's filters
+	static constexpr std::uint32_t jam_detect_time = 30; // ms stalled before the conveyor counts as jammed
+	static constexpr std::uint32_t jam_reverse_time = 150; // ms the conveyor runs backwards to clear a jam
+	static constexpr std::uint32_t jam_start_time = 200; // ms after starting before a stall counts, spinning up looks the same
+	static constexpr int jam_reverse_voltage = 12000; // mV, how hard it runs backwards
+	static constexpr std::array<double, 3> ring_marks = {1100, 1500, 1900}; // conveyor encoder degrees from the optical sensor to the arm, the eject point and the top, in RingMark order
+	static constexpr int ring_proximity = 100; // optical proximity reading (0-255) with a ring in front of it
+	static constexpr double ring_red_hue = 10; // degrees, optical hue of a red ring
+	static constexpr double ring_blue_hue = 215; // degrees, of a blue ring
+	static constexpr double ring_hue_tolerance = 35; // degrees either side of those that still counts as that color
+	static constexpr int ring_current_spike = 400; // mA over the usual conveyor current when a ring gets picked up, if the optical sensor is out
+	static constexpr std::uint32_t ring_current_time = 200; // ms, time constant of that usual current, slow so a spike stands out against it
+	static constexpr double ring_spacing = 200; // conveyor encoder degrees, rings can't enter closer together than this
+	static constexpr double sort_lead = 30; // conveyor encoder degrees before the eject mark to stop, covering sensing and motor delay
+	static constexpr std::uint32_t sort_fling_time = 100; // ms the conveyor stops for so a wrong color ring flies off
+
+	static constexpr std::array<int, 5> arm_presets = {0, 1500, 5000, 14000, 19000}; // centidegrees for stow, load (y), prime, score and descore, in ArmPreset order
+	static constexpr int arm_manual_power = 30; // l2/r2 power out of 127
+	static constexpr std::uint32_t arm_period = 5; // ms between arm controller updates, on its own task
+	static constexpr double arm_kp = 10; // mV per centidegree short of the arm target
+	static constexpr double arm_ki = 20; // mV per centidegree second
+	static constexpr double arm_kd = 0.5; // mV per centidegree per second behind the profile's speed, damps the swing
+	static constexpr double arm_kv = 0.4; // mV per centidegree per second, what holding a speed takes
+	static constexpr double arm_ka = 0.02; // mV per centidegree per second squared, what speeding up takes
+	static constexpr double arm_kg = 1500; // mV that holds the arm up when it is level
+	static constexpr int arm_horizontal = 9000; // centidegrees, rotation reading with the arm level (0 is where it starts, hanging down)
+	static constexpr double arm_max_velocity = 18000; // centidegrees per second the arm's motion profiles go up to
+	static constexpr double arm_max_acceleration = 90000; // centidegrees per second squared, full speed in a fifth of a second
+	static constexpr double arm_integral_limit = 3000; // mV, most the integral can add
+	static constexpr int arm_tolerance = 50; // centidegrees, close enough to an arm target
+	static constexpr std::uint32_t arm_settle_time = 100; // ms within tolerance before the arm counts as settled
+
+	static constexpr int drive_curve = 2; // joystick response curve driver control uses, a ResponseCurve, see response_curve.hpp
+	static constexpr int curve_deadband = 5; // stick values either side of the middle that count as centered
+	static constexpr int curve_min_output = 10; // drive power just outside the deadband, the least that moves the robot
+	static constexpr double curve_expo = 0.6; // how much of the exponential curve is cubic, 0 is a straight line
+	static constexpr std::array<double, 5> curve_piecewise = {0, 0.15, 0.35, 0.6, 1}; // the piecewise curve's output at every quarter of the stick past the deadband, 0-1 of the range above curve_min_output
+
+	static constexpr double heading_kp = 2; // turn power per degree off the held heading, negate both if a positive turn turns the robot anticlockwise
+	static constexpr double heading_kd = 0.05; // turn power per degree per second the robot is turning
+	static constexpr double heading_settle_rate = 30; // degrees per second, the heading is taken once a turn slows below this
+	static constexpr double heading_max_power = 40; // most turn power heading hold adds
+	static constexpr std::uint32_t heading_filter_time = 20; // ms, time constant of the turn rate filter
+	static constexpr std::uint32_t imu_calibration_time = 3000; // ms recording and replay wait for the inertial sensor to calibrate
+
+	static constexpr double drive_kp = 0.3; // power per degree short of a scripted drive_to target
+	static constexpr double drive_straight_kp = 0.5; // power per degree the drive sides drift apart while driving straight
+	static constexpr double drive_tolerance = 20; // degrees of wheel rotation, close enough to a drive_to target
+	static constexpr double drive_accel = 1000; // drive power per second speeding up, standing still to full in 127 ms
+	static constexpr double drive_decel = 2500; // power per second slowing down, full to stopped in 51 ms
+	static constexpr double drive_soft_current = 1800; // mA in any one drive motor, above this the drive speeds up slower
+	static constexpr double drive_hard_current = 2500; // mA, the motors' own limit, where it speeds up slowest
+	static constexpr double drive_min_scale = 0.25; // of drive_accel, the slowest it speeds up
+};
+
+/**
+ * Makes sure every smart port is between 1 and 21 and used at most once, the
+ * ADI port is between 1 and 8, the loop and arm periods are ones the motors
+ * keep up with and the response curve's deadband and minimum output fit in a
+ * stick's range.
+ */
+template <typename Config>
+constexpr bool check_config() {
+	std::array<int, Config::left_drive.size() + Config::right_drive.size() + 5> ports = {};
+	std::size_t count = 0;
+	for (int port : Config::left_drive) ports[count++] = port < 0 ? -port : port;
+	for (int port : Config::right_drive) ports[count++] = port < 0 ? -port : port;
+	ports[count++] = Config::conveyor < 0 ? -Config::conveyor : Config::conveyor;
+	ports[count++] = Config::arm < 0 ? -Config::arm : Config::arm;
+	ports[count++] = Config::rotation;
+	ports[count++] = Config::color;
+	ports[count++] = Config::imu;
+
+	for (std::size_t i = 0; i < count; i++) {
+		if (ports[i] < 1 || ports[i] > 21) return false;
+		for (std::size_t j = i + 1; j < count; j++) {
+			if (ports[i] == ports[j]) return false;
+		}
+	}
+	if (Config::loop_period != 5 && Config::loop_period != 10 && Config::loop_period != 20) return false;
+	if (Config::arm_period < 5 || Config::arm_period > 10) return false;
+	if (Config::curve_deadband < 0 || Config::curve_deadband >= 127 || Config::curve_min_output < 0 || Config::curve_min_output > 127) return false;
+	return Config::clamp >= 1 && Config::clamp <= 8;
+}
+
+static_assert(check_config<HighStakes>(), "HighStakes has a port out of range or used twice, or a bad loop or arm period or response curve");
+
+using RobotConfig = HighStakes; // the robot this tree is built for
+
+}  // namespace robot
+
+#endif  // _ROBOT_CONFIG_HPP_
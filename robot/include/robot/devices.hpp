@@ -0,0 +1,235 @@
+/**
+ * \file devices.hpp
+ *
+ * The robot's V5 devices and the glue between them and robot::Robot: sense()
+ * fills Inputs from the sensors and apply() sends Commands to the motors.
+ */
+
+#ifndef _ROBOT_DEVICES_HPP_
+#define _ROBOT_DEVICES_HPP_
+
+#include "api.h"
+#include "robot/actuators.hpp"
+#include "robot/arm_task.hpp"
+#include "robot/robot.hpp"
+#include "robot/snapshot.hpp"
+#include "robot/trace.hpp"
+#include <cmath>
+
+namespace robot {
+
+/**
+ * Every motor and sensor on the robot, on the ports from the configuration.
+ * Outputs go through the caching wrappers in actuators.hpp so a cycle that
+ * repeats the last one sends nothing.
+ */
+template <typename Config>
+struct BasicDevices {
+	WriteCounter writes; // writes sent and skipped by the last apply()
+	CachedMotor<pros::MotorGroup> left_mg{writes, std::vector<std::int8_t>(Config::left_drive.begin(), Config::left_drive.end())};
+	CachedMotor<pros::MotorGroup> right_mg{writes, std::vector<std::int8_t>(Config::right_drive.begin(), Config::right_drive.end())};
+	CachedMotor<pros::Motor> conveyor{writes, Config::conveyor}; // motor for the conveyor belt
+	CachedDigitalOut clamp{writes, Config::clamp}; // pneumatics solenoid controlling the clamp
+	pros::Rotation rotation{Config::rotation}; // rotation sensor to get location of the arm
+	pros::Optical color{Config::color}; // color sensor at the bottom of the conveyor, sees rings come in
+	pros::Imu imu{Config::imu}; // inertial sensor, calibrated once by calibrate() in initialize
+
+	BasicDevices() {
+		color.set_led_pwm(Config::color_led_pwm); // turn on the color sensor light
+		color.set_integration_time(Config::color_integration_time); // fastest readings, so a passing ring gets a reading of its own
+	}
+
+	/**
+	 * Starts the inertial sensor calibrating without waiting for it, from
+	 * initialize(). It takes about two seconds, with the robot kept still,
+	 * and heading hold stays off until it is done.
+	 */
+	static void calibrate() {
+		pros::Imu(Config::imu).reset(false);
+	}
+
+	/**
+	 * Makes every arm angle relative to where the arm is now. Only from
+	 * initialize(), with the arm hanging down: Devices gets built again on
+	 * every mode change, with the arm wherever autonomous left it.
+	 */
+	static void zero_arm() {
+		pros::Rotation(Config::rotation).reset_position();
+	}
+
+	/**
+	 * Waits up to imu_calibration_time for calibrate() to finish, so a
+	 * recording or replay holds the heading from its first cycle.
+	 */
+	void wait_for_heading() {
+		const std::uint32_t start = pros::millis();
+		while (imu.is_calibrating() && pros::millis() - start < Config::imu_calibration_time) pros::delay(10);
+	}
+
+	/**
+	 * Forgets every cached output, the arm task's too, so the next apply()
+	 * sends everything. At the start of each mode, since whatever ran before
+	 * may have left the motors doing something other than the cache thinks.
+	 */
+	void invalidate() {
+		left_mg.invalidate();
+		right_mg.invalidate();
+		conveyor.invalidate();
+		clamp.invalidate();
+		BasicArmTask<Config>::get().invalidate();
+	}
+
+	/**
+	 * Fills in the sensor half of the inputs. A motor that reads again after
+	 * being unplugged lost its target, so its cache is cleared to resend it.
+	 */
+	void sense(Inputs& in) {
+		sense_conveyor(in);
+		sense_arm(in);
+		sense_drive_current(in);
+		sense_heading(in);
+	}
+
+	void sense_conveyor(Inputs& in) {
+		ROBOT_TRACE_SCOPE("conveyor read");
+		const double power = conveyor.device().get_power();
+		track(conveyor, conveyor_present, power != PROS_ERR_F);
+		in.conveyor_power = power;
+		in.conveyor_current = conveyor.device().get_current_draw();
+		in.conveyor_velocity = conveyor.device().get_actual_velocity();
+		in.conveyor_torque = conveyor.device().get_torque();
+		in.conveyor_position = conveyor.device().get_position();
+		const std::int32_t proximity = color.get_proximity();
+		in.ring_proximity = proximity == PROS_ERR ? -1 : proximity;
+		in.ring_hue = color.get_hue();
+	}
+
+	void sense_arm(Inputs& in) {
+		ROBOT_TRACE_SCOPE("arm read");
+		in.arm_angle = rotation.get_position();
+	}
+
+	void sense_drive_current(Inputs& in) { // one motor at a time, get_current_draw_all() would allocate a vector every cycle
+		ROBOT_TRACE_SCOPE("drive current read");
+		in.left_current = most_current(left_mg, left_present);
+		in.right_current = most_current(right_mg, right_present);
+	}
+
+	void sense_heading(Inputs& in) {
+		ROBOT_TRACE_SCOPE("heading read");
+		const double heading = imu.get_rotation(); // PROS_ERR_F while calibrating, or infinity if the port has something else on it
+		in.has_heading = heading != PROS_ERR_F && std::isfinite(heading);
+		in.heading = in.has_heading ? heading : 0;
+	}
+
+	void sense_drive(Inputs& in) { // not part of sense(), only scripted autonomous steers by the encoders
+		ROBOT_TRACE_SCOPE("drive read");
+		in.left_position = left_mg.device().get_position();
+		in.right_position = right_mg.device().get_position();
+	}
+
+	/**
+	 * Sends one cycle of commands to the motors. The counts in writes are for
+	 * this call only.
+	 */
+	void apply(const Commands& out) {
+		writes.reset();
+		apply_drive(out);
+		apply_conveyor(out);
+		apply_clamp(out);
+		apply_arm(out);
+	}
+
+	// each mechanism on its own, for running them at different rates
+	void apply_drive(const Commands& out) {
+		ROBOT_TRACE_SCOPE("drive write");
+		left_mg.move(out.left);
+		right_mg.move(out.right);
+	}
+
+	void apply_conveyor(const Commands& out) {
+		ROBOT_TRACE_SCOPE("conveyor write");
+		if (trace::enabled && out.conveyor.mode != ConveyorCommand::Keep && out.conveyor.mode != traced_conveyor) {
+			traced_conveyor = out.conveyor.mode;
+			ROBOT_TRACE_COUNTER("conveyor mode", out.conveyor.mode);
+		}
+		switch (out.conveyor.mode) {
+			case ConveyorCommand::Keep: break;
+			case ConveyorCommand::Brake: conveyor.brake(); break;
+			case ConveyorCommand::Move: conveyor.move(out.conveyor.value); break;
+			case ConveyorCommand::Voltage: conveyor.move_voltage(out.conveyor.value); break;
+		}
+	}
+
+	void apply_clamp(const Commands& out) {
+		if (trace::enabled && out.clamp != traced_clamp) {
+			traced_clamp = out.clamp;
+			ROBOT_TRACE_COUNTER("clamp", out.clamp);
+		}
+		clamp.set_value(out.clamp);
+	}
+
+	void apply_arm(const Commands& out) {
+		ROBOT_TRACE_SCOPE("arm write");
+		if (trace::enabled && out.arm.mode != ArmCommand::Keep && out.arm.mode != traced_arm) {
+			traced_arm = out.arm.mode;
+			ROBOT_TRACE_COUNTER("arm mode", out.arm.mode);
+		}
+		BasicArmTask<Config>::get().command(out.arm); // the arm task owns the arm motor, see robot/arm_task.hpp
+	}
+
+private:
+	static int most_current(CachedMotor<pros::MotorGroup>& motors, bool& present) {
+		pros::MotorGroup& group = motors.device();
+		int most = 0;
+		bool all = true;
+		for (std::int8_t i = 0; i < group.size(); i++) {
+			const std::int32_t current = group.get_current_draw(i);
+			if (current == PROS_ERR) all = false;
+			else if (std::abs(current) > most) most = std::abs(current);
+		}
+		track(motors, present, all);
+		return most;
+	}
+
+	template <typename MotorType>
+	static void track(CachedMotor<MotorType>& motor, bool& present, bool now) {
+		if (now && !present) motor.invalidate();
+		present = now;
+	}
+
+	// whether the last read found each motor (every motor of a group) plugged in
+	bool conveyor_present = true;
+	bool left_present = true;
+	bool right_present = true;
+
+	// the last mechanism states put in the trace, so only changes are recorded
+	int traced_conveyor = -1;
+	int traced_clamp = -1;
+	int traced_arm = -1;
+};
+
+using Devices = BasicDevices<RobotConfig>;
+
+/**
+ * Reads every controller channel once. Call it at the top of the cycle and
+ * hand the result to everything that needs the controller.
+ */
+inline Snapshot sample(pros::Controller& controller) {
+	ROBOT_TRACE_SCOPE("controller read");
+	Snapshot snapshot;
+	snapshot.time = pros::millis();
+	snapshot.left_x = controller.get_analog(pros::E_CONTROLLER_ANALOG_LEFT_X);
+	snapshot.left_y = controller.get_analog(pros::E_CONTROLLER_ANALOG_LEFT_Y);
+	snapshot.right_x = controller.get_analog(pros::E_CONTROLLER_ANALOG_RIGHT_X);
+	snapshot.right_y = controller.get_analog(pros::E_CONTROLLER_ANALOG_RIGHT_Y);
+	for (unsigned button = 0; button < static_cast<unsigned>(Button::Count); button++) {
+		const auto channel = static_cast<pros::controller_digital_e_t>(pros::E_CONTROLLER_DIGITAL_L1 + button);
+		if (controller.get_digital(channel) == 1) snapshot.buttons |= 1u << button; // just the level, ButtonTracker finds the edges
+	}
+	return snapshot;
+}
+
+}  // namespace robot
+
+#endif  // _ROBOT_DEVICES_HPP_
@@ -0,0 +1,93 @@
+/**
+ * \file executive.hpp
+ *
+ * A fixed order, multi-rate scheduler for the robot's subsystems.
+ *
+ * Each subsystem is registered with its own period and phase offset. One task
+ * calls tick() every period() ms (the greatest common divisor of all periods),
+ * and every subsystem that is due runs, always in the order it was added. So
+ * the arm can run every 5 ms and the screen every 100 ms without extra tasks,
+ * and the schedule is exactly the same on every run. The time each subsystem
+ * takes is tracked with the clock passed to the constructor.
+ *
+ * It never sleeps, the caller keeps the time. On the brain the loop is
+ *
+ *   std::uint32_t now = pros::millis();
+ *   while (true) {
+ *       executive.tick(now);
+ *       pros::Task::delay_until(&now, executive.period());
+ *   }
+ */
+
+#ifndef _ROBOT_EXECUTIVE_HPP_
+#define _ROBOT_EXECUTIVE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+
+class Executive {
+public:
+	static constexpr std::size_t max_subsystems = 8;
+
+	using Function = void (*)(void* context);
+	using Clock = std::uint64_t (*)(); // microseconds
+
+	/**
+	 * Execution time of one subsystem, in microseconds.
+	 */
+	struct Stats {
+		std::uint32_t runs = 0;
+		std::uint32_t last = 0;
+		std::uint32_t max = 0;
+		std::uint64_t total = 0;
+
+		std::uint32_t mean() const { return runs ? total / runs : 0; }
+	};
+
+	explicit Executive(Clock clock) : clock(clock) {}
+
+	/**
+	 * Registers a subsystem that runs every period ms, starting phase ms into
+	 * the schedule. Returns false if it doesn't fit (too many subsystems, a
+	 * period of 0 or a phase not less than the period).
+	 */
+	bool add(const char* name, std::uint32_t period, std::uint32_t phase, Function function, void* context);
+
+	/**
+	 * Runs every subsystem due at time now (ms). now should advance by
+	 * period() between calls.
+	 */
+	void tick(std::uint32_t now);
+
+	/**
+	 * How often tick() needs to be called, in ms.
+	 */
+	std::uint32_t period() const { return base_period; }
+
+	std::size_t size() const { return count; }
+	const char* name(std::size_t index) const { return subsystems[index].name; }
+	const Stats& stats(std::size_t index) const { return subsystems[index].stats; }
+
+private:
+	struct Subsystem {
+		const char* name;
+		std::uint32_t period;
+		std::uint32_t phase;
+		Function function;
+		void* context;
+		Stats stats;
+	};
+
+	Clock clock;
+	Subsystem subsystems[max_subsystems] = {};
+	std::size_t count = 0;
+	std::uint32_t base_period = 0;
+	bool started = false;
+	std::uint32_t start = 0; // time of the first tick, phases are relative to it
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_EXECUTIVE_HPP_
@@ -0,0 +1,75 @@
+/**
+ * \file heading_hold.hpp
+ *
+ * Keeps the robot pointed the same way while the driver drives straight.
+ *
+ * While the turn stick sits in its deadband and the robot is driving, the
+ * inertial sensor's heading is held with a PD controller, so drift from
+ * uneven motors or a bump gets steered out without the driver fighting it.
+ * The heading to hold is taken once the robot has stopped turning, below
+ * settle_rate, rather than the moment the stick is let go, so the end of a
+ * turn coasts out instead of being pulled back. Moving the turn stick, or
+ * stopping, lets go of it.
+ */
+
+#ifndef _ROBOT_HEADING_HOLD_HPP_
+#define _ROBOT_HEADING_HOLD_HPP_
+
+#include <cstdint>
+
+namespace robot {
+
+struct HeadingSettings {
+	double kp; // turn power per degree off the held heading
+	double kd; // turn power per degree per second turning
+	double settle_rate; // degrees per second, slower than this the heading gets taken
+	double max_power; // most turn power it adds
+	std::uint32_t filter_time; // ms, time constant of the turn rate filter
+};
+
+/**
+ * The heading hold tuning in a robot configuration.
+ */
+template <typename Config>
+constexpr HeadingSettings heading_settings() {
+	HeadingSettings settings;
+	settings.kp = Config::heading_kp;
+	settings.kd = Config::heading_kd;
+	settings.settle_rate = Config::heading_settle_rate;
+	settings.max_power = Config::heading_max_power;
+	settings.filter_time = Config::heading_filter_time;
+	return settings;
+}
+
+class HeadingHold {
+public:
+	explicit HeadingHold(HeadingSettings settings) : settings(settings) {}
+
+	/**
+	 * One cycle at time ms with the inertial sensor's heading in degrees,
+	 * clockwise. holding is whether the driver is driving without turning.
+	 * Returns the turn power to add, 0 while not holding.
+	 */
+	int update(std::uint32_t time, double heading, bool holding);
+
+	/**
+	 * No heading this cycle (the sensor is calibrating or unplugged), forget
+	 * everything until it comes back.
+	 */
+	void reset() { started = false; locked = false; }
+
+	bool holding() const { return locked; }
+
+private:
+	HeadingSettings settings;
+	bool started = false;
+	std::uint32_t last_time = 0;
+	double last_heading = 0;
+	double rate = 0; // degrees per second, filtered
+	bool locked = false; // whether target is being held
+	double target = 0;
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_HEADING_HOLD_HPP_
@@ -0,0 +1,90 @@
+/**
+ * \file ilc.hpp
+ *
+ * Iterative learning control for repeated auton replays.
+ *
+ * Every replay logs what the robot actually did (drive velocities and arm
+ * angle) next to the recorded reference. Between runs the per-frame tracking
+ * error is folded back into the command stream so the next replay lands closer
+ * to the recording. The same code runs in disabled() on the brain and on
+ * Linux through robot/tools/ilc_offline.cpp.
+ */
+
+#ifndef _ROBOT_ILC_HPP_
+#define _ROBOT_ILC_HPP_
+
+#include "robot/response_curve.hpp"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace robot {
+namespace ilc {
+
+/**
+ * One cycle worth of drive and arm values. Depending on the stream this
+ * is either commands (left/right motor power, arm target angle) or
+ * measurements (left/right velocity in rpm, arm angle).
+ */
+struct Frame {
+	int left;
+	int right;
+	int arm;
+};
+
+/**
+ * Learning gains. The leads shift the error forward in time to cover the delay
+ * between sending a command and seeing it on the sensors.
+ */
+struct Gains {
+	double drive = 0.3; // motor power per rpm of velocity error
+	double arm = 0.5; // centidegrees of target shift per centidegree of angle error
+	std::uint32_t drive_lead = 20; // ms
+	std::uint32_t arm_lead = 40; // ms
+	int drive_limit = 127; // max motor power
+	std::uint32_t period = 20; // ms between frames, from the recording header
+};
+
+/**
+ * Root mean square tracking error of one run, used to watch convergence.
+ */
+struct Error {
+	double drive; // rpm
+	double arm; // centidegrees
+};
+
+/**
+ * Reads a recording made by the auton recording project. The commands are the
+ * drive powers Robot::drive asked for while recording, heading hold included,
+ * and the arm angle. The reference is what the robot measured while recording
+ * (left/right velocity, arm angle).
+ * Either output may be NULL. The recording's loop period is stored in period
+ * if it isn't NULL, and whether its lines have the arm angle in has_arm.
+ * Without it the arm frames are all 0, which isn't anything to learn toward.
+ * Recordings from before the powers were logged are shaped with curves, the
+ * robot's BasicRobot::curves.
+ */
+void read_recording(FILE* file, const CurveTables& curves, std::vector<Frame>* commands, std::vector<Frame>* reference, std::uint32_t* period = NULL, bool* has_arm = NULL);
+
+/**
+ * Reads a "left:right:arm" frame stream. A leading "#n" line holds the
+ * iteration count, which is stored in iteration if it isn't NULL.
+ */
+std::vector<Frame> read_frames(FILE* file, int* iteration);
+
+/**
+ * Writes a frame stream in the format read_frames expects.
+ */
+void write_frames(FILE* file, const std::vector<Frame>& frames, int iteration);
+
+/**
+ * Runs one learning iteration, refining commands in place from the error
+ * between reference and measured. Frames past the end of the shorter stream
+ * are left untouched. Returns the tracking error of the run that was measured.
+ */
+Error update(const std::vector<Frame>& reference, const std::vector<Frame>& measured, std::vector<Frame>& commands, const Gains& gains = Gains());
+
+}  // namespace ilc
+}  // namespace robot
+
+#endif  // _ROBOT_ILC_HPP_
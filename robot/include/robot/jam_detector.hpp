@@ -0,0 +1,85 @@
+/**
+ * \file jam_detector.hpp
+ *
+ * Notices the conveyor stalling against a stuck ring and runs it backwards
+ * for a moment to clear it.
+ *
+ * Current, velocity and torque are each low pass filtered, so one noisy
+ * reading neither triggers nor hides a jam. A jam is all three agreeing: the
+ * motor pulling hard, making torque and barely turning, for detect_time while
+ * it is supposed to be running forward. The detector then asks for
+ * reverse_time of reverse before the conveyor carries on, and doesn't look
+ * again for start_time, since a motor spinning up looks just like a stall.
+ * With the HighStakes tuning a stall is reversed 80 ms after it starts, see
+ * robot/bench/jam_sim.cpp.
+ */
+
+#ifndef _ROBOT_JAM_DETECTOR_HPP_
+#define _ROBOT_JAM_DETECTOR_HPP_
+
+#include <cstdint>
+
+namespace robot {
+
+struct JamSettings {
+	double current; // mA, at least this
+	double velocity; // rpm, at most this fast either way
+	double torque; // Nm, at least this
+	std::uint32_t filter_time; // ms, time constant of the filters
+	std::uint32_t detect_time; // ms stalled before it counts as a jam
+	std::uint32_t reverse_time; // ms to run backwards
+	std::uint32_t start_time; // ms after starting or resuming before stalls count
+};
+
+/**
+ * The jam detector settings in a robot configuration.
+ */
+template <typename Config>
+constexpr JamSettings jam_settings() {
+	JamSettings settings;
+	settings.current = Config::jam_current;
+	settings.velocity = Config::jam_velocity;
+	settings.torque = Config::jam_torque;
+	settings.filter_time = Config::jam_filter_time;
+	settings.detect_time = Config::jam_detect_time;
+	settings.reverse_time = Config::jam_reverse_time;
+	settings.start_time = Config::jam_start_time;
+	return settings;
+}
+
+class JamDetector {
+public:
+	explicit JamDetector(JamSettings settings) : settings(settings) {}
+
+	/**
+	 * One cycle at time ms. running is whether the conveyor is supposed to be
+	 * going forward. Returns true while it should be reversing instead.
+	 */
+	bool update(std::uint32_t time, bool running, int current, double velocity, double torque);
+
+	/**
+	 * Whether the last update ended a reverse, so the forward command has to
+	 * be sent again.
+	 */
+	bool resumed() const { return just_resumed; }
+
+	std::uint32_t jams() const { return count; } // since the program started
+
+private:
+	JamSettings settings;
+	bool started = false; // whether the filters hold a reading yet
+	std::uint32_t last_time = 0;
+	double current = 0, velocity = 0, torque = 0; // filtered
+	bool was_running = false;
+	std::uint32_t running_since = 0; // ms, when it last started or resumed
+	bool stalled = false;
+	std::uint32_t stalled_since = 0;
+	bool reversing = false;
+	std::uint32_t reversing_since = 0;
+	bool just_resumed = false;
+	std::uint32_t count = 0;
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_JAM_DETECTOR_HPP_
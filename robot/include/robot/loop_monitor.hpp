@@ -0,0 +1,91 @@
+/**
+ * \file loop_monitor.hpp
+ *
+ * Measures how regularly a control loop actually runs.
+ *
+ * Call begin() at the top of every iteration and end() when its work is done,
+ * both with a microsecond timestamp (pros::micros() on the brain). The monitor
+ * keeps fixed bucket histograms of the period between iterations and of the
+ * execution time of each, plus a count of deadline overruns (iterations whose
+ * work took longer than the period). Both calls are a handful of integer
+ * operations with no allocation, well under a microsecond on the brain.
+ */
+
+#ifndef _ROBOT_LOOP_MONITOR_HPP_
+#define _ROBOT_LOOP_MONITOR_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace robot {
+
+/**
+ * Counts values into fixed width buckets starting at low. Values outside the
+ * range land in the first or last bucket.
+ */
+class Histogram {
+public:
+	static constexpr std::size_t buckets = 16;
+
+	Histogram(std::int32_t low, std::uint32_t width) : low(low), width(width ? width : 1) {}
+
+	void add(std::int32_t value);
+
+	std::int32_t bucket_start(std::size_t bucket) const { return low + (std::int32_t) (bucket * width); }
+	std::uint32_t count(std::size_t bucket) const { return counts[bucket]; }
+	std::uint32_t samples() const { return total_count; }
+	std::int32_t min() const { return total_count ? min_value : 0; }
+	std::int32_t max() const { return total_count ? max_value : 0; }
+	std::int32_t mean() const { return total_count ? (std::int32_t) (sum / total_count) : 0; }
+
+private:
+	std::int32_t low;
+	std::uint32_t width;
+	std::uint32_t counts[buckets] = {};
+	std::uint32_t total_count = 0;
+	std::int32_t min_value = 0;
+	std::int32_t max_value = 0;
+	std::int64_t sum = 0;
+};
+
+class LoopMonitor {
+public:
+	/**
+	 * period is the loop's intended period in microseconds. The period
+	 * histogram covers a quarter period either side of it, the execution time
+	 * histogram covers 0 to period.
+	 */
+	explicit LoopMonitor(std::uint32_t period);
+
+	void begin(std::uint64_t now);
+	void end(std::uint64_t now);
+
+	const Histogram& periods() const { return period_histogram; }
+	const Histogram& execution() const { return execution_histogram; }
+	std::uint32_t overruns() const { return overrun_count; }
+
+	/**
+	 * One line summaries for the brain screen, e.g.
+	 * "period 9998/10000/10012 us" and "exec 210/340/1890 us over 0".
+	 */
+	int format_period(char* buffer, std::size_t size) const;
+	int format_execution(char* buffer, std::size_t size) const;
+
+	/**
+	 * Writes both histograms as text, e.g. to a file on the sd card.
+	 */
+	void dump(FILE* file) const;
+
+private:
+	std::uint32_t period;
+	Histogram period_histogram;
+	Histogram execution_histogram;
+	std::uint32_t overrun_count = 0;
+	std::uint64_t last_begin = 0;
+	bool started = false;
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_LOOP_MONITOR_HPP_
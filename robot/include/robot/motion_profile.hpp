@@ -0,0 +1,63 @@
+/**
+ * \file motion_profile.hpp
+ *
+ * Time optimal trapezoidal motion profiles: accelerate at the limit, cruise at
+ * the top speed if there is room to reach it, then decelerate at the limit so
+ * the move ends at rest exactly on the goal. Sampling a profile gives the
+ * position, velocity and acceleration a mechanism should have at that moment,
+ * which the arm controller follows with feedforward instead of chasing the
+ * final angle. Units are whatever the caller uses, the arm uses centidegrees
+ * and seconds.
+ */
+
+#ifndef _ROBOT_MOTION_PROFILE_HPP_
+#define _ROBOT_MOTION_PROFILE_HPP_
+
+namespace robot {
+
+/**
+ * Where the mechanism should be at one moment of a profile.
+ */
+struct Setpoint {
+	double position;
+	double velocity;
+	double acceleration;
+};
+
+class TrapezoidProfile {
+public:
+	TrapezoidProfile() = default;
+
+	/**
+	 * A move from start to goal, already moving at start_velocity, within
+	 * max_velocity and max_acceleration. A start velocity away from the goal
+	 * is dropped, and one too fast to stop in time decelerates harder than
+	 * max_acceleration so the profile still ends on the goal.
+	 */
+	TrapezoidProfile(double start, double goal, double max_velocity, double max_acceleration, double start_velocity = 0);
+
+	/**
+	 * The setpoint time s after the start. Before the start it is the start,
+	 * after the end it is the goal at rest.
+	 */
+	Setpoint sample(double time) const;
+
+	double duration() const { return accelerating + cruising + decelerating; }
+	double goal() const { return start + direction * distance; }
+
+private:
+	double start = 0;
+	double direction = 1; // +1 or -1, everything below is along it
+	double distance = 0;
+	double start_velocity = 0;
+	double peak_velocity = 0;
+	double acceleration = 0;
+	double deceleration = 0;
+	double accelerating = 0; // s in each phase
+	double cruising = 0;
+	double decelerating = 0;
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_MOTION_PROFILE_HPP_
@@ -0,0 +1,138 @@
+/**
+ * \file profile.hpp
+ *
+ * Timing probes for the hot paths, compiled away unless asked for.
+ *
+ * Build a program with `make clean && make PROFILE=1` to define ROBOT_PROFILE
+ * and turn them on. Otherwise every probe below is empty and none of
+ * profile.cpp gets linked.
+ *
+ * Probes are keyed by string literals. Each call site looks its probe up once
+ * and keeps it in a static, so after the first time a probe costs two clock
+ * reads and a few additions. Each probe should only be hit from one task.
+ *
+ *   robot::profile::time("motor writes", [&] { devices.apply(out); });
+ *
+ *   {
+ *       ROBOT_PROBE("cycle"); // times until the end of the block
+ *       ...
+ *   }
+ *
+ *   ROBOT_COUNT("dropped"); // just counts
+ */
+
+#ifndef _ROBOT_PROFILE_HPP_
+#define _ROBOT_PROFILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace robot::profile {
+
+using Clock = std::uint64_t (*)(); // microseconds
+
+#ifdef ROBOT_PROFILE
+
+constexpr bool enabled = true;
+
+/**
+ * One probe's totals, in microseconds. Counters only have count.
+ */
+struct Probe {
+	const char* name = nullptr;
+	bool timed = false;
+	std::uint32_t count = 0;
+	std::uint32_t min = 0;
+	std::uint32_t max = 0;
+	std::uint64_t total = 0;
+
+	std::uint32_t mean() const { return count ? total / count : 0; }
+};
+
+constexpr std::size_t max_probes = 32;
+
+/**
+ * Sets the clock every probe reads, pros::micros on the brain. Call it before
+ * any probe is hit.
+ */
+void init(Clock clock);
+
+/**
+ * The probe called name, added the first time it is asked for. Every probe
+ * past max_probes shares one called "(other)".
+ */
+Probe* probe(const char* name, bool timed);
+
+std::uint64_t now();
+void record(Probe* probe, std::uint32_t took);
+
+class Scope {
+public:
+	explicit Scope(Probe* probe) : probe(probe), start(now()) {}
+	~Scope() { record(probe, now() - start); }
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	Probe* probe;
+	std::uint64_t start;
+};
+
+/**
+ * Runs function, timing it under name. Every lambda is its own type, so every
+ * call site gets its own cached lookup.
+ */
+template<typename Function> inline void time(const char* name, Function function) {
+	static Probe* const site = probe(name, true);
+	Scope scope(site);
+	function();
+}
+
+std::size_t size();
+const Probe& at(std::size_t index);
+
+/**
+ * One probe as a line, e.g. "sense 6000x 41/52/180 us".
+ */
+int format(char* buffer, std::size_t size, const Probe& probe);
+
+/**
+ * Writes every probe, one per line.
+ */
+void dump(FILE* file);
+
+/**
+ * Zeroes every probe's totals, keeping the probes.
+ */
+void reset();
+
+#define ROBOT_PROFILE_JOIN2(a, b) a##b
+#define ROBOT_PROFILE_JOIN(a, b) ROBOT_PROFILE_JOIN2(a, b)
+#define ROBOT_PROBE(name) \
+	static ::robot::profile::Probe* const ROBOT_PROFILE_JOIN(robot_probe_, __LINE__) = ::robot::profile::probe(name, true); \
+	::robot::profile::Scope ROBOT_PROFILE_JOIN(robot_scope_, __LINE__)(ROBOT_PROFILE_JOIN(robot_probe_, __LINE__))
+#define ROBOT_COUNT(name) \
+	do { \
+		static ::robot::profile::Probe* const robot_counter = ::robot::profile::probe(name, false); \
+		robot_counter->count++; \
+	} while (0)
+
+#else
+
+constexpr bool enabled = false;
+
+inline void init(Clock) {}
+template<typename Function> inline void time(const char*, Function function) { function(); }
+inline void dump(FILE*) {}
+inline void reset() {}
+
+#define ROBOT_PROBE(name) ((void) 0)
+#define ROBOT_COUNT(name) ((void) 0)
+
+#endif
+
+}  // namespace robot::profile
+
+#endif  // _ROBOT_PROFILE_HPP_
@@ -0,0 +1,74 @@
+/**
+ * \file recording.hpp
+ *
+ * The format of /usd/recording.txt. The first line is a header with the loop
+ * period the recording was made at and the ResponseCurve it was driven with,
+ *
+ *   #period 10 curve 2
+ *
+ * followed by one line per cycle:
+ *
+ *   dir:turn:arm_angle:left_velocity:right_velocity:left_power:right_power[buttons]
+ *
+ * where buttons is one letter per button held (a b r l x y L R ^ v < > for a b
+ * r1 l1 x y l2 r2 and the arrows). dir and turn are the sticks before the
+ * curve, and the powers are what Robot::drive made of them, curve and heading
+ * hold included. Recordings from before the header existed were made at
+ * 20 ms, those from before the curve was in it were driven on the linear
+ * curve, the ones from before the powers were added stop at right_velocity,
+ * and the ones from before the arm angle and velocities were added only have
+ * dir:turn.
+ */
+
+#ifndef _ROBOT_RECORDING_HPP_
+#define _ROBOT_RECORDING_HPP_
+
+#include "robot/robot.hpp"
+#include "robot/snapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * The period of recordings that have no header.
+ */
+constexpr std::uint32_t legacy_period = 20;
+
+/**
+ * Writes the header line (with its newline) into buffer. Returns the length
+ * written, like snprintf.
+ */
+int format_header(char* buffer, std::size_t size, std::uint32_t period, ResponseCurve curve);
+
+/**
+ * Reads the period and curve out of a header line. Returns false if line
+ * isn't one. curve may be NULL.
+ */
+bool parse_header(const char* line, std::uint32_t* period, ResponseCurve* curve = NULL);
+
+/**
+ * Everything recorded for one cycle.
+ */
+struct RecordedCycle {
+	Inputs in;
+	int left_velocity = 0; // rpm
+	int right_velocity = 0; // rpm
+	int left_power = 0; // out of 127, Robot::left_request
+	int right_power = 0;
+};
+
+/**
+ * Writes one cycle as a line (with its newline) into buffer. Returns the
+ * length written, like snprintf.
+ */
+int format_cycle(char* buffer, std::size_t size, const RecordedCycle& cycle);
+
+/**
+ * The buttons held in a recorded line, as Snapshot::buttons bits.
+ */
+std::uint16_t parse_buttons(const char* line);
+
+}  // namespace robot
+
+#endif  // _ROBOT_RECORDING_HPP_
@@ -0,0 +1,107 @@
+/**
+ * \file response_curve.hpp
+ *
+ * Joystick response curves, mapping a stick reading to a drive power.
+ *
+ * Every curve other than Linear ignores the stick inside curve_deadband, then
+ * jumps to curve_min_output (the least power that actually moves the robot)
+ * and shapes the rest of the travel up to 127. The tables are worked out at
+ * compile time from a configuration (BasicRobot keeps its Config's), one
+ * entry for every value get_analog can return, so applying a curve is one
+ * array index. Which curve a recording
+ * was driven with is in its header (see recording.hpp) so the replay uses the
+ * same one.
+ */
+
+#ifndef _ROBOT_RESPONSE_CURVE_HPP_
+#define _ROBOT_RESPONSE_CURVE_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+
+enum class ResponseCurve : std::uint8_t {
+	Linear, // power is the stick, as every recording made before curves existed was driven
+	Deadband, // straight line from curve_min_output to 127
+	Exponential, // gentle near the middle for fine control, curve_expo of it cubic
+	Piecewise, // straight lines through the curve_piecewise points
+	Count
+};
+
+using CurveTable = std::array<std::int8_t, 256>; // indexed by the stick reading cast to std::uint8_t
+using CurveTables = std::array<CurveTable, static_cast<std::size_t>(ResponseCurve::Count)>; // one for every ResponseCurve
+
+namespace curve_detail {
+
+template <typename Config>
+constexpr double shape(ResponseCurve curve, double t) { // 0-1 past the deadband to 0-1 of the range above min_output
+	switch (curve) {
+		case ResponseCurve::Exponential: return Config::curve_expo * t * t * t + (1 - Config::curve_expo) * t;
+		case ResponseCurve::Piecewise: {
+			constexpr std::size_t segments = Config::curve_piecewise.size() - 1;
+			const std::size_t i = t >= 1 ? segments - 1 : static_cast<std::size_t>(t * segments);
+			const double along = t * segments - i;
+			return Config::curve_piecewise[i] + along * (Config::curve_piecewise[i + 1] - Config::curve_piecewise[i]);
+		}
+		default: return t;
+	}
+}
+
+template <typename Config>
+constexpr CurveTable make_table(ResponseCurve curve) {
+	CurveTable table = {};
+	for (int stick = -128; stick <= 127; stick++) {
+		const int magnitude = stick < 0 ? (stick == -128 ? 127 : -stick) : stick; // -128 never comes from a stick, treat it as -127
+		int power = magnitude;
+		if (curve != ResponseCurve::Linear) {
+			if (magnitude <= Config::curve_deadband) {
+				power = 0;
+			} else {
+				const double t = (double) (magnitude - Config::curve_deadband) / (127 - Config::curve_deadband);
+				power = static_cast<int>(Config::curve_min_output + (127 - Config::curve_min_output) * shape<Config>(curve, t) + 0.5);
+			}
+		}
+		table[static_cast<std::uint8_t>(static_cast<std::int8_t>(stick))] = static_cast<std::int8_t>(stick < 0 ? -power : power);
+	}
+	return table;
+}
+
+}  // namespace curve_detail
+
+/**
+ * Every curve's table for a configuration.
+ */
+template <typename Config>
+constexpr CurveTables make_curve_tables() {
+	CurveTables tables = {};
+	for (std::size_t curve = 0; curve < tables.size(); curve++) tables[curve] = curve_detail::make_table<Config>(static_cast<ResponseCurve>(curve));
+	return tables;
+}
+
+/**
+ * The power for a stick reading on curve, from tables made by
+ * make_curve_tables.
+ */
+constexpr int apply_curve(const CurveTables& tables, ResponseCurve curve, int stick) {
+	return tables[static_cast<std::size_t>(curve)][static_cast<std::uint8_t>(stick)];
+}
+
+/**
+ * Whether the linear curve leaves the stick alone and every curve reaches full
+ * power at full stick, for a static_assert on the configuration.
+ */
+constexpr bool check_curves(const CurveTables& tables) {
+	for (int stick = -127; stick <= 127; stick++) {
+		if (apply_curve(tables, ResponseCurve::Linear, stick) != stick) return false;
+	}
+	for (std::size_t curve = 0; curve < tables.size(); curve++) {
+		if (apply_curve(tables, static_cast<ResponseCurve>(curve), 127) != 127 || apply_curve(tables, static_cast<ResponseCurve>(curve), -127) != -127) return false;
+	}
+	return true;
+}
+
+}  // namespace robot
+
+#endif  // _ROBOT_RESPONSE_CURVE_HPP_
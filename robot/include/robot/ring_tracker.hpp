@@ -0,0 +1,125 @@
+/**
+ * \file ring_tracker.hpp
+ *
+ * Follows each ring up the conveyor on the conveyor motor's encoder.
+ *
+ * A ring entering is seen by the optical sensor at the bottom of the
+ * conveyor, as its proximity reading rising past ring_proximity. Without a
+ * working optical sensor, a spike in conveyor current over its recent level
+ * stands in for it. While the ring is in front of the sensor its hue gives
+ * its color. From then on the ring's place is simply how far the belt
+ * has moved since, so the control code can act when a ring reaches a mark
+ * along the conveyor (see RingMark) instead of after a guessed delay. The
+ * belt running backwards carries the rings back with it, and one that goes
+ * back out the bottom is forgotten.
+ */
+
+#ifndef _ROBOT_RING_TRACKER_HPP_
+#define _ROBOT_RING_TRACKER_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * Places along the conveyor, at the distances in RingSettings::marks.
+ */
+enum class RingMark : std::uint8_t {
+	Arm, // sitting on the arm when it is in the load preset
+	Eject, // where a ring can be flung off the side
+	Top, // off the top onto the stake, the ring is done
+	Count
+};
+
+enum class RingColor : std::uint8_t { None, Red, Blue };
+
+const char* name(RingColor color);
+
+struct RingSettings {
+	int proximity; // optical proximity reading a ring in front of the sensor gives
+	double red_hue; // degrees
+	double blue_hue;
+	double hue_tolerance; // degrees either side of those still counting
+	int current_spike; // mA over the recent level that means a ring got picked up
+	std::uint32_t current_time; // ms, time constant of that recent level
+	double spacing; // degrees, two entries closer than this are the same ring
+	std::array<double, static_cast<std::size_t>(RingMark::Count)> marks; // degrees from the sensor to each RingMark
+};
+
+/**
+ * The ring tracker settings in a robot configuration.
+ */
+template <typename Config>
+constexpr RingSettings ring_settings() {
+	RingSettings settings;
+	settings.proximity = Config::ring_proximity;
+	settings.red_hue = Config::ring_red_hue;
+	settings.blue_hue = Config::ring_blue_hue;
+	settings.hue_tolerance = Config::ring_hue_tolerance;
+	settings.current_spike = Config::ring_current_spike;
+	settings.current_time = Config::ring_current_time;
+	settings.spacing = Config::ring_spacing;
+	settings.marks = Config::ring_marks;
+	return settings;
+}
+
+/**
+ * The color of a ring in front of the optical sensor, None if there isn't
+ * one or it is neither color.
+ */
+RingColor classify(double hue, int proximity, const RingSettings& settings);
+
+class RingTracker {
+public:
+	static constexpr std::size_t max_rings = 8; // more than fit on the conveyor
+
+	struct Ring {
+		std::uint32_t id; // counts up from 1, one per ring seen
+		double entered; // encoder position when it went past the sensor
+		RingColor color; // None until the sensor gets a good look at it
+		std::uint32_t seen; // ms, when its color was read
+	};
+
+	explicit RingTracker(RingSettings settings) : settings(settings) {}
+
+	/**
+	 * One cycle at time ms. position is the conveyor encoder in degrees,
+	 * proximity and hue the optical sensor's readings (proximity negative if
+	 * it can't be read) and current the conveyor's draw in mA.
+	 */
+	void update(std::uint32_t time, double position, int proximity, double hue, int current);
+
+	/**
+	 * Whether a ring got to mark during the last update, and which one.
+	 */
+	bool reached(RingMark mark) const { return arrivals & bit(mark); }
+	std::uint32_t arrived(RingMark mark) const { return arrival_ids[static_cast<std::size_t>(mark)]; }
+
+	std::size_t size() const { return count; } // rings on the conveyor
+	const Ring& ring(std::size_t i) const { return rings[i]; } // oldest first
+	double travel(const Ring& ring) const { return position - ring.entered; } // degrees up the conveyor
+	std::uint32_t seen() const { return next_id - 1; } // rings that have entered since the program started
+
+private:
+	static constexpr std::uint8_t bit(RingMark mark) { return 1u << static_cast<unsigned>(mark); }
+	void enter();
+
+	RingSettings settings;
+	Ring rings[max_rings];
+	std::size_t count = 0;
+	std::uint32_t next_id = 1;
+	bool started = false;
+	std::uint32_t last_time = 0;
+	double position = 0;
+	bool near = false; // proximity above the threshold last update
+	double current = 0; // recent level of the conveyor current, mA
+	bool spiking = false;
+	std::uint8_t arrivals = 0; // one bit per RingMark
+	std::uint32_t arrival_ids[static_cast<std::size_t>(RingMark::Count)] = {};
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_RING_TRACKER_HPP_
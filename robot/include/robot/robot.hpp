@@ -0,0 +1,199 @@
+/**
+ * \file robot.hpp
+ *
+ * The conveyor, clamp, arm and drive logic shared by auton recording, auton
+ * replay and driver control.
+ *
+ * All three programs fill in the same Inputs each cycle (from the controller
+ * or from a recording), call Robot::step and send the returned Commands to the
+ * motors. Since they run the exact same code, a replay does exactly what the
+ * driver did while recording. The host benchmarks and simulations in
+ * robot/bench drive it the same way.
+ *
+ * The logic is templated on a configuration from config.hpp so the ports and
+ * tuning constants are compile time values. Robot is the one this robot uses.
+ */
+
+#ifndef _ROBOT_ROBOT_HPP_
+#define _ROBOT_ROBOT_HPP_
+
+#include "robot/color_sort.hpp"
+#include "robot/config.hpp"
+#include "robot/heading_hold.hpp"
+#include "robot/jam_detector.hpp"
+#include "robot/response_curve.hpp"
+#include "robot/ring_tracker.hpp"
+#include "robot/slew_limiter.hpp"
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * Named arm positions, at the angles in the configuration's arm_presets.
+ */
+enum class ArmPreset : std::int8_t {
+	Stow, // down out of the way
+	Load, // catches a ring off the conveyor
+	Prime, // ring lifted clear, ready to swing
+	Score, // over the wall stake
+	Descore, // past it, knocking the top ring off
+	Count
+};
+
+const char* name(ArmPreset preset);
+
+/**
+ * What the arm is doing, see BasicRobot::arm.
+ */
+enum class ArmState : std::uint8_t {
+	Holding, // braked wherever it was left
+	Manual, // l2/r2 moving it by hand
+	Moving, // on its way to a preset
+	AtPreset, // there, and held there on the rotation sensor
+};
+
+/**
+ * Everything the robot logic looks at in one cycle.
+ */
+struct Inputs {
+	std::uint32_t time = 0; // ms, for anything that has to time itself
+	int dir = 0; // forward/backward, left stick y already inverted, before the response curve
+	int turn = 0; // left/right turn, right stick x
+
+	bool a = false; // conveyor start
+	bool b = false; // conveyor stop
+	bool r1 = false; // conveyor slow forward
+	bool l1 = false; // conveyor slow reverse
+	bool x = false; // clamp button
+	bool y = false; // arm load preset
+	bool l2 = false; // arm reverse
+	bool r2 = false; // arm forward
+	bool up = false; // arm score preset
+	bool down = false; // arm stow preset
+	bool left = false; // arm descore preset
+	bool right = false; // arm prime preset
+	bool clamp_toggle = false; // x was pressed this cycle, an event rather than a level
+	int arm_preset = -1; // the ArmPreset whose button was pressed this cycle, -1 if none, also an event
+
+	double conveyor_power = 0; // W, from conveyor.get_power()
+	int conveyor_current = 0; // mA, from conveyor.get_current_draw()
+	double conveyor_velocity = 0; // rpm, from conveyor.get_actual_velocity()
+	double conveyor_torque = 0; // Nm, from conveyor.get_torque()
+	double conveyor_position = 0; // degrees, from conveyor.get_position()
+	int ring_proximity = -1; // 0-255, from color.get_proximity(), negative if it couldn't be read
+	double ring_hue = 0; // degrees, from color.get_hue()
+	int arm_angle = 0; // centidegrees, from the rotation sensor
+	double left_position = 0; // degrees, left drive encoder, only read for scripted autonomous
+	double right_position = 0; // degrees, right drive encoder
+	int left_current = 0; // mA, the most any one left drive motor draws, from left_mg.get_current_draw(i)
+	int right_current = 0; // mA, right drive
+	double heading = 0; // degrees clockwise, from imu.get_rotation()
+	bool has_heading = false; // false while the inertial sensor is calibrating or can't be read
+
+	bool has_arm_target = false; // replay and scripted autonomous: go to an absolute arm angle instead of using the buttons
+	int arm_target = 0; // centidegrees
+	bool has_drive = false; // replay and scripted autonomous: drive at these powers instead of dir and turn
+	int drive_left = 0; // power out of 127
+	int drive_right = 0;
+	bool has_conveyor = false; // scripted autonomous: run the conveyor at conveyor_command instead of using the buttons
+	int conveyor_command = 0; // power out of 127, 0 brakes it
+};
+
+/**
+ * What to do with the conveyor motor this cycle.
+ */
+struct ConveyorCommand {
+	enum Mode {
+		Keep, // send nothing, whatever was last sent keeps going
+		Brake,
+		Move, // value is power out of 127
+		Voltage // value is mV
+	};
+	Mode mode = Keep;
+	int value = 0;
+};
+
+/**
+ * What to do with the arm motor this cycle.
+ */
+struct ArmCommand {
+	enum Mode {
+		Keep, // send nothing, whatever was last sent keeps going
+		Hold, // stop and hold position against gravity
+		Move, // value is power out of 127
+		Target // value is an angle in centidegrees for the arm controller to go to and hold, see arm_controller.hpp
+	};
+	Mode mode = Hold;
+	int value = 0;
+};
+
+/**
+ * Everything the robot logic wants sent to the devices in one cycle.
+ */
+struct Commands {
+	int left = 0; // left drive power out of 127
+	int right = 0; // right drive power out of 127
+	ConveyorCommand conveyor;
+	bool clamp = false; // true is clamped
+	ArmCommand arm;
+};
+
+/**
+ * The robot's control logic and the state it carries between cycles.
+ */
+template <typename Config>
+class BasicRobot {
+	static_assert(check_config<Config>(), "robot configuration has a port out of range or used twice, or a bad loop or arm period or response curve");
+	static_assert(Config::arm_presets.size() == static_cast<std::size_t>(ArmPreset::Count), "robot configuration needs an angle for every arm preset");
+	static_assert(Config::drive_curve >= 0 && Config::drive_curve < static_cast<int>(ResponseCurve::Count), "robot configuration has a drive curve that doesn't exist");
+
+public:
+	static constexpr CurveTables curves = make_curve_tables<Config>(); // every response curve shaped by this configuration
+	static_assert(check_curves(curves), "robot configuration has a response curve that doesn't reach full power at full stick");
+
+	/**
+	 * Runs one cycle of every mechanism.
+	 */
+	Commands step(const Inputs& in);
+
+	// each mechanism on its own, step runs all of them in this order
+	void drive(const Inputs& in, Commands& out);
+	void conveyor(const Inputs& in, Commands& out);
+	void clamp(const Inputs& in, Commands& out);
+	void arm(const Inputs& in, Commands& out);
+
+	std::uint32_t conveyor_jams() const { return jam.jams(); }
+	const RingTracker& rings() const { return ring_tracker; } // where each ring is on the conveyor, and which marks they reached this cycle
+	void sort_out(RingColor color) { sorter.reject(color); } // the other alliance's color, None to keep every ring
+	const ColorSorter& sorting() const { return sorter; }
+	ArmState arm_state() const { return state; }
+	ArmPreset arm_preset() const { return preset; } // the last one asked for
+	void use_curve(ResponseCurve curve) { this->curve = curve; } // replay: the one the recording was driven with
+	ResponseCurve response_curve() const { return curve; }
+	bool holding_heading() const { return heading_hold.holding(); }
+	int left_request() const { return requested_left; } // the last drive powers asked for, after the curve and heading hold and before slew limiting
+	int right_request() const { return requested_right; }
+
+private:
+	ResponseCurve curve = static_cast<ResponseCurve>(Config::drive_curve); // for both sticks
+	HeadingHold heading_hold{heading_settings<Config>()}; // steers out drift while the turn stick is centered, see heading_hold.hpp
+	SlewLimiter left_slew{slew_settings<Config>()}, right_slew{slew_settings<Config>()}; // ease the drive toward what was asked, see slew_limiter.hpp
+	int requested_left = 0, requested_right = 0; // what they were asked for, the recorder logs it for learning
+	bool conveyor_moving = false; // if the conveyor is supposed to be running at full speed
+	ConveyorCommand running; // the last command that runs the conveyor forward, to go back to after a jam
+	bool conveyor_forward = false; // if the conveyor is supposed to be running forward
+	JamDetector jam{jam_settings<Config>()};
+	RingTracker ring_tracker{ring_settings<Config>()};
+	ColorSorter sorter{sort_settings<Config>()};
+	bool clamped = false; // if the clamp is currently down
+	ArmState state = ArmState::Holding;
+	ArmPreset preset = ArmPreset::Stow;
+};
+
+// compiled once into librobot.a, see robot.cpp
+extern template class BasicRobot<RobotConfig>;
+using Robot = BasicRobot<RobotConfig>;
+
+}  // namespace robot
+
+#endif  // _ROBOT_ROBOT_HPP_
@@ -0,0 +1,266 @@
+/**
+ * \file sequencer.hpp
+ *
+ * Scripted autonomous routines written as C++20 coroutines:
+ *
+ *   robot::auton::Routine skills() {
+ *       using namespace robot::auton;
+ *       co_await drive_to(-900);
+ *       co_await clamp(true);
+ *       co_await all(drive_to(0), arm_to(robot::ArmPreset::Load)); // both at once
+ *   }
+ *
+ * Each step sets a target and suspends until it is reached. Nothing blocks:
+ * the control loop calls Sequencer::tick every cycle, which resumes every step
+ * whose condition has come true, and again for any step that finishes within
+ * the same tick, so the next step starts on the cycle the last one ended. all()
+ * runs its steps side by side on that same tick, so running the drive and the
+ * arm together takes no extra task, stack or mutex.
+ *
+ * Coroutine frames come from a fixed pool in sequencer.cpp rather than the
+ * heap, and a Routine doesn't start until it is awaited or handed to
+ * Sequencer::start. Everything runs on the task that calls tick.
+ */
+
+#ifndef _ROBOT_SEQUENCER_HPP_
+#define _ROBOT_SEQUENCER_HPP_
+
+#include "robot/robot.hpp"
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+
+namespace robot::auton {
+
+class Sequencer;
+
+/**
+ * A step or a whole routine. co_await one to run it and carry on when it
+ * finishes.
+ */
+class Routine {
+public:
+	struct promise_type {
+		std::coroutine_handle<> continuation; // whoever awaited this, resumed when it finishes
+
+		Routine get_return_object() { return Routine(std::coroutine_handle<promise_type>::from_promise(*this)); }
+		std::suspend_always initial_suspend() noexcept { return {}; }
+		auto final_suspend() noexcept {
+			struct Resume {
+				bool await_ready() noexcept { return false; }
+				std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> finished) noexcept {
+					const std::coroutine_handle<> next = finished.promise().continuation;
+					return next ? next : std::noop_coroutine();
+				}
+				void await_resume() noexcept {}
+			};
+			return Resume{};
+		}
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+
+		// from the frame pool, see sequencer.cpp
+		static void* operator new(std::size_t size);
+		static void operator delete(void* frame, std::size_t size);
+	};
+
+	Routine() = default;
+	Routine(Routine&& other) : handle(other.handle) { other.handle = nullptr; }
+	Routine& operator=(Routine&& other);
+	~Routine();
+
+	/**
+	 * Runs it up to its first wait, without anyone to resume when it is done.
+	 */
+	void start();
+	bool done() const { return !handle || handle.done(); }
+
+	bool await_ready() const { return done(); }
+	std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) {
+		handle.promise().continuation = awaiting;
+		return handle; // straight into it, on this same tick
+	}
+	void await_resume() {}
+
+private:
+	explicit Routine(std::coroutine_handle<promise_type> handle) : handle(handle) {}
+
+	std::coroutine_handle<promise_type> handle;
+};
+
+/**
+ * Checked every tick for a suspended step. context is whatever the step
+ * passed to Until.
+ */
+using Condition = bool (*)(const Sequencer& sequencer, const void* context);
+
+/**
+ * Suspends until condition is true. Doesn't suspend at all if it already is.
+ */
+struct Until {
+	Condition condition;
+	const void* context = nullptr;
+
+	bool await_ready() const;
+	void await_suspend(std::coroutine_handle<> awaiting) const;
+	void await_resume() const {}
+};
+
+/**
+ * Drive and arm tuning for scripted steps.
+ */
+struct Settings {
+	double drive_kp; // power per degree short of the target
+	double straight_kp; // power per degree the two sides drift apart
+	double drive_tolerance; // degrees, close enough to a drive_to target
+	int arm_tolerance; // centidegrees, close enough to an arm_to target
+	std::array<int, static_cast<std::size_t>(ArmPreset::Count)> arm_presets; // centidegrees, where arm_to sends each ArmPreset
+};
+
+/**
+ * The scripted step tuning in a robot configuration.
+ */
+template <typename Config>
+constexpr Settings sequencer_settings() {
+	Settings settings;
+	settings.drive_kp = Config::drive_kp;
+	settings.straight_kp = Config::drive_straight_kp;
+	settings.drive_tolerance = Config::drive_tolerance;
+	settings.arm_tolerance = Config::arm_tolerance;
+	settings.arm_presets = Config::arm_presets;
+	return settings;
+}
+
+/**
+ * Runs one routine from the control loop.
+ */
+class Sequencer {
+public:
+	static constexpr std::size_t max_waiting = 16; // steps suspended at once
+
+	explicit Sequencer(Settings settings) : settings(settings) {}
+
+	/**
+	 * Replaces whatever was running. It begins on the next tick, and drive
+	 * positions are measured from where the robot is then.
+	 */
+	void start(Routine routine);
+	bool done() const { return routine.done(); }
+
+	/**
+	 * Call every cycle after sensing and before Robot::step, with the time in
+	 * ms. Resumes every step whose wait is over, then points the arm at its
+	 * target and sets the drive and conveyor powers through in.
+	 */
+	void tick(std::uint32_t time, Inputs& in);
+
+	/**
+	 * Call after Robot::step. Replaces the clamp once a step has set it.
+	 */
+	void apply(Commands& out) const;
+
+	/**
+	 * The sequencer inside tick, for the steps.
+	 */
+	static Sequencer& active();
+
+	// what the steps ask for and look at
+	void wait(Condition condition, const void* context, std::coroutine_handle<> awaiting);
+	void drive(double target, int power);
+	void stop_drive() { driving = false; }
+	void arm(int target);
+	int preset_angle(ArmPreset preset) const { return settings.arm_presets[static_cast<std::size_t>(preset)]; }
+	void conveyor(int power);
+	void clamp(bool clamped);
+
+	std::uint32_t time() const { return now; }
+	double position() const { return (left + right) / 2; } // degrees driven since the routine started
+	bool drive_settled() const;
+	bool arm_settled() const;
+
+private:
+	struct Waiting {
+		Condition condition;
+		const void* context;
+		std::coroutine_handle<> awaiting;
+	};
+
+	Settings settings;
+	Routine routine;
+	bool started = false;
+	Waiting waiting[max_waiting];
+	std::size_t waiting_count = 0;
+
+	std::uint32_t now = 0;
+	double origin_left = 0, origin_right = 0;
+	double left = 0, right = 0; // drive positions, degrees from the origin
+	int arm_angle = 0;
+
+	bool driving = false;
+	double drive_target = 0;
+	int drive_power = 0;
+	bool has_arm_target = false;
+	int arm_target = 0;
+	bool has_conveyor = false;
+	int conveyor_power = 0;
+	bool has_clamp = false;
+	bool clamped = false;
+};
+
+/**
+ * Drives straight until position() is within tolerance of position, at up to
+ * power out of 127, then stops.
+ */
+Routine drive_to(double position, int power = 100);
+
+/**
+ * Moves the arm to angle in centidegrees, or to a preset's angle, and holds it
+ * there. Done once it is within tolerance.
+ */
+Routine arm_to(int angle);
+Routine arm_to(ArmPreset preset);
+
+/**
+ * Waits ms.
+ */
+Routine wait(std::uint32_t ms);
+
+/**
+ * Runs the conveyor at power out of 127, 0 brakes it. Done straight away.
+ */
+Routine conveyor(int power);
+
+/**
+ * Sets the clamp. Done straight away.
+ */
+Routine clamp(bool clamped);
+
+/**
+ * Steps that all() is waiting on.
+ */
+struct Group {
+	Routine* const* steps;
+	std::size_t size;
+};
+
+/**
+ * Starts every step in group, and is true once they have all finished.
+ */
+void start_all(const Group& group);
+bool all_done(const Sequencer& sequencer, const void* group);
+
+/**
+ * Runs every step at once and finishes when the last one does.
+ */
+template <typename... Steps>
+Routine all(Steps... steps) {
+	Routine* const list[] = {&steps...};
+	const Group group{list, sizeof...(Steps)};
+	start_all(group);
+	co_await Until{all_done, &group};
+}
+
+}  // namespace robot::auton
+
+#endif  // _ROBOT_SEQUENCER_HPP_
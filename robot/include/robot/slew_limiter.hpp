@@ -0,0 +1,70 @@
+/**
+ * \file slew_limiter.hpp
+ *
+ * Eases one side of the drivetrain from its last power to the one asked for
+ * instead of jumping straight there.
+ *
+ * A full stick reversal sent as-is slams the motors from full forward to full
+ * reverse in one cycle. That pulls a current spike that browns out the other
+ * mechanisms, and breaks the wheels loose, so a replay of it ends up
+ * somewhere different every time. The limiter caps how fast the power can
+ * change. Speeding up is capped at accel. Slowing down is allowed to go
+ * faster, at decel. A reversal first slows to zero, then speeds up the other
+ * way. While the side's motors are already drawing more than soft_current,
+ * speeding up gets slower still, down to min_scale of accel at hard_current.
+ * The rates are per second and measured on the cycle times, so the loop rate
+ * doesn't change them.
+ */
+
+#ifndef _ROBOT_SLEW_LIMITER_HPP_
+#define _ROBOT_SLEW_LIMITER_HPP_
+
+#include <cstdint>
+
+namespace robot {
+
+struct SlewSettings {
+	double accel; // power out of 127 per second, speeding up
+	double decel; // power per second, slowing down or stopping for a reversal
+	double soft_current; // mA, above this speeding up gets slower
+	double hard_current; // mA, where it is down to min_scale
+	double min_scale; // of accel, the slowest it gets
+	std::uint32_t max_step = 50; // ms, a longer gap between updates (disabled, say) counts as this long
+};
+
+/**
+ * The drive slew limits in a robot configuration.
+ */
+template <typename Config>
+constexpr SlewSettings slew_settings() {
+	SlewSettings settings;
+	settings.accel = Config::drive_accel;
+	settings.decel = Config::drive_decel;
+	settings.soft_current = Config::drive_soft_current;
+	settings.hard_current = Config::drive_hard_current;
+	settings.min_scale = Config::drive_min_scale;
+	return settings;
+}
+
+class SlewLimiter {
+public:
+	explicit SlewLimiter(SlewSettings settings) : settings(settings) {}
+
+	/**
+	 * One cycle at time ms. target is the power asked for and current the
+	 * most any one motor on this side draws, in mA. Returns the power to send.
+	 */
+	int update(std::uint32_t time, int target, int current);
+
+	int power() const; // the last one returned
+
+private:
+	SlewSettings settings;
+	bool started = false;
+	std::uint32_t last_time = 0;
+	double output = 0; // kept unrounded so slow rates still add up
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_SLEW_LIMITER_HPP_
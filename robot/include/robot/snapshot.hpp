@@ -0,0 +1,49 @@
+/**
+ * \file snapshot.hpp
+ *
+ * One cycle's worth of controller state.
+ *
+ * Every channel of the controller is read exactly once at the top of each
+ * cycle (see sample in devices.hpp) into a Snapshot. Control, recording and the
+ * screen all read from that same snapshot, so they always agree on what the
+ * driver was doing and no channel gets read twice.
+ */
+
+#ifndef _ROBOT_SNAPSHOT_HPP_
+#define _ROBOT_SNAPSHOT_HPP_
+
+#include "robot/robot.hpp"
+#include <cstdint>
+
+namespace robot {
+
+/**
+ * Controller buttons, in the order of pros::controller_digital_e_t.
+ */
+enum class Button : std::uint8_t { L1, L2, R1, R2, Up, Down, Left, Right, X, B, Y, A, Count };
+
+/**
+ * Every controller channel at one instant.
+ */
+struct Snapshot {
+	std::uint32_t time = 0; // ms since the program started
+	std::int8_t left_x = 0;
+	std::int8_t left_y = 0;
+	std::int8_t right_x = 0;
+	std::int8_t right_y = 0;
+	std::uint16_t buttons = 0; // one bit per Button, set if it was held when sampled. ButtonTracker finds the presses and releases
+
+	bool held(Button button) const { return buttons & (1u << static_cast<unsigned>(button)); }
+};
+
+struct ButtonEvents;
+
+/**
+ * The driver's control mapping: which sticks, buttons and button events feed
+ * which inputs. Only the controller half of Inputs is filled in.
+ */
+Inputs controls(const Snapshot& snapshot, const ButtonEvents& events);
+
+}  // namespace robot
+
+#endif  // _ROBOT_SNAPSHOT_HPP_
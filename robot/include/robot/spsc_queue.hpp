@@ -0,0 +1,74 @@
+/**
+ * \file spsc_queue.hpp
+ *
+ * A lock free ring buffer for handing data from exactly one producer task to
+ * exactly one consumer task.
+ *
+ * Neither side ever blocks or takes a mutex: push fails (and counts a drop)
+ * when the buffer is full and pop fails when it is empty. That makes it safe
+ * for the control task to hand frames to slower logging and display tasks
+ * without ever waiting on them. Items are copied in and out, so T should be a
+ * small plain struct. Capacity must be a power of two.
+ */
+
+#ifndef _ROBOT_SPSC_QUEUE_HPP_
+#define _ROBOT_SPSC_QUEUE_HPP_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+
+template <typename T, std::size_t Capacity>
+class SpscQueue {
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	/**
+	 * Producer side. Returns false and counts a drop if the queue is full.
+	 */
+	bool push(const T& item) {
+		const std::size_t tail = write.load(std::memory_order_relaxed);
+		if (tail - read.load(std::memory_order_acquire) == Capacity) {
+			dropped_count.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		items[tail & (Capacity - 1)] = item;
+		write.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Consumer side. Returns false if the queue is empty.
+	 */
+	bool pop(T& item) {
+		const std::size_t head = read.load(std::memory_order_relaxed);
+		if (head == write.load(std::memory_order_acquire)) return false;
+		item = items[head & (Capacity - 1)];
+		read.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/**
+	 * Items waiting, only exact when called from one of the two sides.
+	 */
+	std::size_t size() const { return write.load(std::memory_order_acquire) - read.load(std::memory_order_acquire); }
+
+	/**
+	 * Pushes that failed because the queue was full.
+	 */
+	std::uint32_t dropped() const { return dropped_count.load(std::memory_order_relaxed); }
+
+	static constexpr std::size_t capacity() { return Capacity; }
+
+private:
+	T items[Capacity];
+	std::atomic<std::size_t> write{0}; // only the producer stores
+	std::atomic<std::size_t> read{0}; // only the consumer stores
+	std::atomic<std::uint32_t> dropped_count{0};
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_SPSC_QUEUE_HPP_
@@ -0,0 +1,201 @@
+/**
+ * \file task_profiler.hpp
+ *
+ * Watches every task the program starts: its state, priority, stack high water
+ * mark and how much of the CPU it uses, so stack overflows and starved tasks
+ * show up before a match. It is built on the pros::c task calls, which only
+ * the brain has.
+ *
+ * Each task calls join() first thing, which paints its stack, and ran() after
+ * every loop iteration with how long the iteration took. start() launches a
+ * low priority task that samples every joined task once per interval. It
+ * rewrites the table in /usd/tasks.txt, prints it to the terminal and
+ * remembers a warning when a stack drops under an eighth free or a task goes
+ * three periods without running. The CPU share is busy time over wall time,
+ * so time spent preempted while busy counts too.
+ */
+
+#ifndef _ROBOT_TASK_PROFILER_HPP_
+#define _ROBOT_TASK_PROFILER_HPP_
+
+#include "api.h"
+#include "robot/task_stats.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+namespace robot {
+
+class TaskProfiler {
+public:
+	static constexpr std::size_t max_tasks = 8;
+	static constexpr std::uint32_t stack_margin = 2048; // bytes left unpainted at the bottom of the stack, for what the task used before join()
+
+	/**
+	 * Adds the calling task. stack_depth is in words, as given to pros::Task
+	 * (TASK_STACK_DEPTH_DEFAULT for opcontrol and autonomous). period is how
+	 * often it calls ran() in ms, 0 if it doesn't. Returns the slot to pass to
+	 * ran(), -1 if there are too many tasks. Joining again under the same
+	 * name reuses that name's slot.
+	 *
+	 * The paint goes stack_size - stack_margin down from the caller, so the
+	 * caller has to have used less than stack_margin by then. A function's
+	 * locals are all on the stack from its first line, so a task with big
+	 * ones joins from a small function and then calls one that has them, like
+	 * opcontrol() in driver control.
+	 */
+	int join(const char* name, std::uint32_t stack_depth, std::uint32_t period) {
+		std::size_t slot = 0;
+		while (slot < size() && !(entries[slot].stats.name && std::strcmp(entries[slot].stats.name, name) == 0)) slot++;
+		if (slot == size()) { // a task that has joined before, like opcontrol after every restart, gets its old slot back
+			slot = claimed++;
+			if (slot >= max_tasks) return -1;
+		}
+		Entry& entry = entries[slot];
+		entry.ready = false;
+		entry.task = pros::c::task_get_current();
+		std::strncpy(entry.rtos_name, pros::c::task_get_name(NULL), sizeof(entry.rtos_name) - 1);
+		entry.stats.name = name;
+		entry.stats.stack_size = stack_depth * sizeof(std::uint32_t);
+		entry.stats.period = period;
+		entry.painted = entry.stats.stack_size - stack_margin;
+		entry.bottom = paint_stack(entry.painted);
+		entry.last_run = pros::millis();
+		entry.ready = true; // only sampled once it is filled in
+		return slot;
+	}
+
+	/**
+	 * Takes the task in slot out of the samples, from the end of a task that
+	 * returns. A task deleted from outside, like opcontrol when the robot is
+	 * disabled, is noticed by sample() instead.
+	 */
+	void leave(int slot) {
+		if (slot >= 0) entries[slot].ready = false;
+	}
+
+	/**
+	 * Reports one loop iteration of the task in slot, busy us long.
+	 */
+	void ran(int slot, std::uint32_t busy) {
+		if (slot < 0) return;
+		entries[slot].busy += busy;
+		entries[slot].last_run = pros::millis();
+	}
+
+	/**
+	 * Starts sampling every interval ms on a low priority task. Only the first
+	 * call does anything. Call it before alloc::start(): the task, the file
+	 * and the terminal's buffer are all set up in here, so the samples
+	 * themselves never allocate.
+	 */
+	void start(std::uint32_t interval = 1000) {
+		if (started.exchange(true)) return;
+		this->interval = interval;
+		file = fopen("/usd/tasks.txt", "w");
+		report();
+		pros::Task([this] {
+			const int slot = join("profiler", TASK_STACK_DEPTH_DEFAULT, this->interval); // its own stack and cpu are in the table too
+			std::uint64_t last = pros::micros();
+			while (true) {
+				pros::delay(this->interval);
+				const std::uint64_t now = pros::micros();
+				sample(now - last);
+				last = now;
+				report();
+				ran(slot, pros::micros() - now);
+			}
+		}, TASK_PRIORITY_MIN + 1, TASK_STACK_DEPTH_DEFAULT, "profiler");
+	}
+
+	std::size_t size() const { return claimed < max_tasks ? claimed.load() : max_tasks; }
+	const TaskStats& stats(std::size_t slot) const { return entries[slot].stats; }
+
+	/**
+	 * The worst problem seen so far, e.g. "stack low: control 812 B", or
+	 * "tasks ok".
+	 */
+	int format_warning(char* buffer, std::size_t size) const {
+		if (warning_task == nullptr) return snprintf(buffer, size, "tasks ok");
+		return snprintf(buffer, size, "%s: %s %u%s", warning_kind, warning_task, (unsigned) warning_value, warning_unit);
+	}
+
+private:
+	struct Entry {
+		pros::task_t task = nullptr;
+		char rtos_name[32] = {}; // what the kernel calls it, to look it up by without touching task
+		std::uint32_t* bottom = nullptr;
+		std::uint32_t painted = 0;
+		std::atomic<std::uint32_t> busy{0};
+		std::atomic<std::uint32_t> last_run{0};
+		std::atomic<bool> ready{false};
+		TaskStats stats;
+	};
+
+	void sample(std::uint32_t window) {
+		const std::uint32_t now = pros::millis();
+		for (std::size_t i = 0; i < size(); i++) {
+			Entry& entry = entries[i];
+			if (!entry.ready) continue;
+			TaskStats& stats = entry.stats;
+			// a deleted task's handle points at freed memory, so ask the kernel whether it still has a task by that name and handle first
+			if (pros::c::task_get_by_name(entry.rtos_name) != entry.task) {
+				stats.state = pros::E_TASK_STATE_DELETED; // and its stack is gone too
+				continue;
+			}
+			stats.state = pros::c::task_get_state(entry.task);
+			stats.priority = pros::c::task_get_priority(entry.task);
+			stats.stack_unused = unused_stack(entry.bottom, entry.painted);
+			stats.busy = entry.busy.exchange(0);
+			stats.window = window;
+			stats.since_run = now - entry.last_run;
+			if (stats.late()) stats.starved++;
+
+			if (stats.stack_low()) warn("stack low", stats.name, stats.stack_unused, " B");
+			else if (stats.late()) warn("starved", stats.name, stats.since_run, " ms");
+		}
+	}
+
+	void warn(const char* kind, const char* task, std::uint32_t value, const char* unit) {
+		warning_kind = kind;
+		warning_task = task;
+		warning_value = value;
+		warning_unit = unit;
+	}
+
+	void report() {
+		char line[96];
+		if (file != NULL) rewind(file); // always the latest sample, so its there whenever the card gets pulled
+		printf("%u tasks running\n", (unsigned) pros::c::task_get_count());
+		for (std::size_t i = 0; i < size(); i++) {
+			if (!entries[i].ready) continue;
+			format_task(line, sizeof(line), entries[i].stats);
+			printf("%s\n", line);
+			if (file != NULL) fprintf(file, "%s\n", line);
+		}
+		format_warning(line, sizeof(line));
+		printf("%s\n", line);
+		if (file != NULL) {
+			fprintf(file, "%s\n", line);
+			const long length = ftell(file);
+			for (long i = length; i < file_length; i++) fputc('\n', file); // blank out the end of a longer last sample
+			file_length = length;
+			fflush(file);
+		}
+	}
+
+	Entry entries[max_tasks];
+	std::atomic<std::size_t> claimed{0}; // slots handed out by join(), a task can be preempted before filling its one in
+	std::uint32_t interval = 1000;
+	FILE* file = nullptr; // /usd/tasks.txt, open for good once start() is called
+	long file_length = 0; // of the last sample written to it
+	std::atomic<bool> started{false};
+	const char* warning_kind = nullptr;
+	const char* warning_task = nullptr;
+	std::uint32_t warning_value = 0;
+	const char* warning_unit = "";
+};
+
+}  // namespace robot
+
+#endif  // _ROBOT_TASK_PROFILER_HPP_
@@ -0,0 +1,63 @@
+/**
+ * \file task_stats.hpp
+ *
+ * The PROS free half of the task profiler in task_profiler.hpp: stack painting
+ * and what gets reported for each task.
+ *
+ * PROS has no call for a task's stack high water mark, so each task paints
+ * its own unused stack when it starts. Whatever still holds the paint later
+ * has never been used, which gives the least free stack the task has had.
+ */
+
+#ifndef _ROBOT_TASK_STATS_HPP_
+#define _ROBOT_TASK_STATS_HPP_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace robot {
+
+constexpr std::uint32_t stack_paint = 0xA5A5A5A5;
+
+/**
+ * Fills bytes of the calling task's stack, starting just below this call's
+ * own frame, with stack_paint. Returns the lowest painted word. Call it first
+ * thing in the task, and leave a margin: bytes has to be less than the stack
+ * left at that point or it paints over whatever is below the stack.
+ */
+std::uint32_t* paint_stack(std::size_t bytes);
+
+/**
+ * Bytes from bottom up that still hold the paint, out of the bytes painted.
+ */
+std::size_t unused_stack(const std::uint32_t* bottom, std::size_t bytes);
+
+/**
+ * One task as the profiler last saw it.
+ */
+struct TaskStats {
+	const char* name = nullptr;
+	std::uint32_t state = 0; // pros::task_state_e_t
+	std::uint32_t priority = 0;
+	std::uint32_t stack_size = 0; // bytes
+	std::uint32_t stack_unused = 0; // bytes never used, counting down only
+	std::uint32_t busy = 0; // us the task reported working during the last window
+	std::uint32_t window = 0; // us the last window lasted
+	std::uint32_t period = 0; // ms the task should report at least every, 0 if it doesnt loop
+	std::uint32_t since_run = 0; // ms since the task last reported
+	std::uint32_t starved = 0; // windows where it went 3 periods without reporting
+
+	std::uint32_t cpu() const { return window ? (std::uint64_t) busy * 100 / window : 0; } // percent
+	bool stack_low() const { return stack_unused < stack_size / 8; }
+	bool late() const { return period && since_run > 3 * period; }
+};
+
+/**
+ * One task as a line, e.g.
+ * "control blocked p14 stack 29480/32768 free cpu 4% starved 0".
+ */
+int format_task(char* buffer, std::size_t size, const TaskStats& task);
+
+}  // namespace robot
+
+#endif  // _ROBOT_TASK_STATS_HPP_
@@ -0,0 +1,164 @@
+/**
+ * \file trace.hpp
+ *
+ * An event tracer for looking at a whole run on a timeline.
+ *
+ * Build a program with `make clean && make TRACE=1` to define ROBOT_TRACE and
+ * turn it on. Otherwise every call below is empty and none of trace.cpp is
+ * linked. Events go into a fixed RAM ring buffer that any task can write to
+ * without blocking. A background task calls flush() to move them to the sd
+ * card (/usd/trace.bin), and on Linux
+ *
+ *   ./bin/host/trace_to_json trace.bin trace.json
+ *
+ * turns the file into Chrome trace JSON for Perfetto or chrome://tracing. Each
+ * task gets its own track.
+ *
+ * ROBOT_TRACE_SCOPE times the rest of a block, ROBOT_TRACE_BEGIN and
+ * ROBOT_TRACE_END a span that isn't one. ROBOT_TRACE_INSTANT marks a moment
+ * and ROBOT_TRACE_COUNTER a changing value. Each looks its name up once.
+ *
+ * The file is a Header followed by Records. A Name record is followed by
+ * value bytes of the name. Ids are only ever defined by a Name record, which
+ * can come after the events that use it.
+ */
+
+#ifndef _ROBOT_TRACE_HPP_
+#define _ROBOT_TRACE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace robot::trace {
+
+enum class Kind : std::uint8_t {
+	Begin, // a span starts
+	End, // the most recent span on the same task ends
+	Instant, // something happened
+	Counter, // a value changed, e.g. a mechanism's state
+	Name, // defines name, followed by value bytes of text
+};
+
+struct Header {
+	char magic[4] = {'R', 'T', 'R', 'C'};
+	std::uint32_t version = 1;
+};
+
+/**
+ * One event, as stored in RAM and in the file (little endian, like both the
+ * brain and a PC).
+ */
+struct Record {
+	std::uint32_t time; // us since init()
+	std::int32_t value; // the counter value, or the length of a Name's text
+	std::uint16_t name; // what happened
+	std::uint16_t task; // the name id of the task it happened on
+	Kind kind;
+	std::uint8_t reserved[3];
+};
+static_assert(sizeof(Record) == 16);
+
+/**
+ * Reads the header. Returns false if file isn't a trace.
+ */
+bool read_header(FILE* file);
+
+/**
+ * Reads the next record, and for a Name its text into text (always
+ * terminated). Returns false at the end of the file or a cut off record.
+ */
+bool read_record(FILE* file, Record* record, char* text, std::size_t size);
+
+using Clock = std::uint64_t (*)(); // microseconds
+using TaskName = const char* (*)(); // the running task's name, must not block
+
+#ifdef ROBOT_TRACE
+
+constexpr bool enabled = true;
+constexpr std::size_t capacity = 2048; // records, 32 KB
+constexpr std::size_t max_names = 128;
+
+void init(Clock clock, TaskName task);
+
+/**
+ * The id of name, added the first time it is asked for. name has to outlive
+ * the program, a string literal.
+ */
+std::uint16_t id(const char* name);
+
+void begin(std::uint16_t name);
+void end(std::uint16_t name);
+void instant(std::uint16_t name);
+void counter(std::uint16_t name, std::int32_t value);
+
+/**
+ * Writes the header (on the first call), every name added since the last
+ * call and every buffered record to file. Call it from one low priority
+ * task. Returns the number of records written.
+ */
+std::size_t flush(FILE* file);
+
+/**
+ * Records lost because the buffer was full.
+ */
+std::uint32_t dropped();
+
+class Scope {
+public:
+	explicit Scope(std::uint16_t name) : name(name) { begin(name); }
+	~Scope() { end(name); }
+
+	Scope(const Scope&) = delete;
+	Scope& operator=(const Scope&) = delete;
+
+private:
+	std::uint16_t name;
+};
+
+// each call site looks its name up once
+#define ROBOT_TRACE_JOIN2(a, b) a##b
+#define ROBOT_TRACE_JOIN(a, b) ROBOT_TRACE_JOIN2(a, b)
+#define ROBOT_TRACE_SCOPE(name) \
+	static const std::uint16_t ROBOT_TRACE_JOIN(robot_trace_id_, __LINE__) = ::robot::trace::id(name); \
+	::robot::trace::Scope ROBOT_TRACE_JOIN(robot_trace_scope_, __LINE__)(ROBOT_TRACE_JOIN(robot_trace_id_, __LINE__))
+#define ROBOT_TRACE_BEGIN(name) \
+	do { \
+		static const std::uint16_t robot_trace_id = ::robot::trace::id(name); \
+		::robot::trace::begin(robot_trace_id); \
+	} while (0)
+#define ROBOT_TRACE_END(name) \
+	do { \
+		static const std::uint16_t robot_trace_id = ::robot::trace::id(name); \
+		::robot::trace::end(robot_trace_id); \
+	} while (0)
+#define ROBOT_TRACE_INSTANT(name) \
+	do { \
+		static const std::uint16_t robot_trace_id = ::robot::trace::id(name); \
+		::robot::trace::instant(robot_trace_id); \
+	} while (0)
+#define ROBOT_TRACE_COUNTER(name, value) \
+	do { \
+		static const std::uint16_t robot_trace_id = ::robot::trace::id(name); \
+		::robot::trace::counter(robot_trace_id, value); \
+	} while (0)
+
+#else
+
+constexpr bool enabled = false;
+
+inline void init(Clock, TaskName) {}
+inline std::size_t flush(FILE*) { return 0; }
+inline std::uint32_t dropped() { return 0; }
+
+#define ROBOT_TRACE_SCOPE(name) ((void) 0)
+#define ROBOT_TRACE_BEGIN(name) ((void) 0)
+#define ROBOT_TRACE_END(name) ((void) 0)
+#define ROBOT_TRACE_INSTANT(name) ((void) 0)
+#define ROBOT_TRACE_COUNTER(name, value) ((void) 0)
+
+#endif
+
+}  // namespace robot::trace
+
+#endif  // _ROBOT_TRACE_HPP_
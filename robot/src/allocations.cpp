@@ -0,0 +1,162 @@
+// the __wrap_ hooks for newlib's allocator, only called once the program links with --wrap (ALLOC_TRACE=1)
+#define ROBOT_ALLOC_TRACE
+#include "robot/allocations.hpp"
+#include <atomic>
+
+// the real allocator, --wrap renames newlib's functions to these
+extern "C" {
+void* __real__malloc_r(void* reent, std::size_t size);
+void* __real__realloc_r(void* reent, void* pointer, std::size_t size);
+void __real__free_r(void* reent, void* pointer);
+}
+
+namespace robot::alloc {
+namespace {
+
+// fixed tables, counting an allocation can't allocate. A task only ever adds
+// its own entries, so the same task and phase are never claimed twice.
+struct Entry {
+	std::atomic<bool> claimed{false};
+	std::atomic<bool> ready{false};
+	const char* task = nullptr;
+	const char* phase = nullptr;
+	std::atomic<std::uint32_t> allocations{0};
+	std::atomic<std::uint32_t> frees{0};
+	std::atomic<std::uint32_t> bytes{0};
+	std::atomic<std::uint32_t> late{0};
+};
+constexpr std::size_t max_entries = 32;
+Entry entries[max_entries]; // the last one collects everything that doesnt fit
+
+struct TaskPhase {
+	std::atomic<bool> claimed{false};
+	std::atomic<bool> ready{false};
+	const char* task = nullptr;
+	std::atomic<const char*> phase{nullptr};
+};
+constexpr std::size_t max_tasks = 16;
+TaskPhase phases[max_tasks];
+
+std::atomic<TaskName> task_name{nullptr};
+std::atomic<bool> running{false};
+std::atomic<std::uint32_t> late_count{0};
+std::atomic<const Entry*> first_late{nullptr};
+std::atomic<std::uint32_t> first_late_size{0};
+
+const char* current_task() {
+	TaskName name = task_name.load();
+	return name ? name() : nullptr;
+}
+
+template<typename Slot> bool claim(Slot& slot) {
+	bool expected = false;
+	return slot.claimed.compare_exchange_strong(expected, true);
+}
+
+Entry& entry(const char* task, const char* phase) {
+	for (std::size_t i = 0; i < max_entries - 1; i++) {
+		if (entries[i].ready && entries[i].task == task && entries[i].phase == phase) return entries[i];
+	}
+	for (std::size_t i = 0; i < max_entries - 1; i++) {
+		if (claim(entries[i])) {
+			entries[i].task = task;
+			entries[i].phase = phase;
+			entries[i].ready = true;
+			return entries[i];
+		}
+	}
+	return entries[max_entries - 1];
+}
+
+TaskPhase* task_phase(const char* task, bool add) {
+	for (std::size_t i = 0; i < max_tasks; i++) {
+		if (phases[i].ready && phases[i].task == task) return &phases[i];
+	}
+	if (!add) return nullptr;
+	for (std::size_t i = 0; i < max_tasks; i++) {
+		if (claim(phases[i])) {
+			phases[i].task = task;
+			phases[i].ready = true;
+			return &phases[i];
+		}
+	}
+	return nullptr;
+}
+
+void record(std::size_t size) {
+	const char* task = current_task();
+	const TaskPhase* current = task_phase(task, false);
+	Entry& site = entry(task, current ? current->phase.load() : nullptr);
+	site.allocations++;
+	site.bytes += size;
+	if (running) {
+		site.late++;
+		if (late_count++ == 0) {
+			first_late_size = size;
+			first_late = &site;
+		}
+	}
+}
+
+void record_free() {
+	const char* task = current_task();
+	const TaskPhase* current = task_phase(task, false);
+	entry(task, current ? current->phase.load() : nullptr).frees++;
+}
+
+const char* name_or(const char* name, const char* fallback) { return name ? name : fallback; }
+
+}  // namespace
+
+void init(TaskName current) { task_name = current; }
+
+void phase(const char* name) {
+	TaskPhase* current = task_phase(current_task(), true);
+	if (current) current->phase = name;
+}
+
+void start() { running = true; }
+void stop() { running = false; }
+
+std::uint32_t late() { return late_count; }
+
+int format_late(char* buffer, std::size_t size) {
+	const Entry* site = first_late;
+	if (site == nullptr) return snprintf(buffer, size, "late allocs 0");
+	return snprintf(buffer, size, "late allocs %u, first %u B %s/%s", (unsigned) late_count.load(), (unsigned) first_late_size.load(),
+	                name_or(site->task, "?"), name_or(site->phase, "-"));
+}
+
+void dump(FILE* file) {
+	fprintf(file, "task/phase allocations frees bytes late\n");
+	for (std::size_t i = 0; i < max_entries; i++) {
+		const Entry& site = entries[i];
+		if (site.allocations == 0 && site.frees == 0) continue;
+		fprintf(file, "%s/%s %u %u %u %u\n", i == max_entries - 1 ? "(other)" : name_or(site.task, "?"), name_or(site.phase, "-"),
+		        (unsigned) site.allocations.load(), (unsigned) site.frees.load(), (unsigned) site.bytes.load(), (unsigned) site.late.load());
+	}
+	char line[96];
+	format_late(line, sizeof(line));
+	fprintf(file, "%s\n", line);
+}
+
+}  // namespace robot::alloc
+
+extern "C" {
+
+void* __wrap__malloc_r(void* reent, std::size_t size) {
+	robot::alloc::record(size);
+	return __real__malloc_r(reent, size);
+}
+
+void* __wrap__realloc_r(void* reent, void* pointer, std::size_t size) {
+	robot::alloc::record(size);
+	return __real__realloc_r(reent, pointer, size);
+}
+
+void __wrap__free_r(void* reent, void* pointer) {
+	if (pointer) robot::alloc::record_free();
+	__real__free_r(reent, pointer);
+}
+
+}
@@ -0,0 +1,58 @@
+#include "robot/arm_controller.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace robot {
+
+void ArmController::set_target(int angle) {
+	if (active && angle == target_angle) return;
+	if (!active) { // the last reading could be from long ago, and the arm was let go since
+		started = false;
+		current = {0, 0, 0};
+	}
+	active = true;
+	target_angle = angle;
+	planned = false;
+	integral = 0;
+	in_tolerance = false;
+	is_settled = false;
+}
+
+int ArmController::update(int angle, std::uint64_t time) {
+	if (!active) return 0;
+	const double dt = started ? (time - last_time) / 1e6 : 0; // s
+	const double rate = dt > 0 ? (angle - last_angle) / dt : 0; // centidegrees per second
+	started = true;
+	last_angle = angle;
+	last_time = time;
+
+	if (!planned) { // carrying on at the old profile's speed if it was heading the same way
+		profile = TrapezoidProfile(angle, target_angle, gains.max_velocity, gains.max_acceleration, current.velocity);
+		profile_start = time;
+		planned = true;
+	}
+	current = profile.sample((time - profile_start) / 1e6);
+	const bool finished = time - profile_start >= profile.duration() * 1e6;
+
+	const double error = current.position - angle;
+	if (finished && std::abs(target_angle - angle) <= gains.tolerance) {
+		if (!in_tolerance) entered = time;
+		in_tolerance = true;
+		is_settled = time - entered >= gains.settle_time * 1000ull;
+	} else {
+		in_tolerance = false;
+		is_settled = false;
+	}
+
+	if (gains.ki > 0) { // limited so a long stall doesn't wind it up into an overshoot
+		const double limit = gains.integral_limit / gains.ki;
+		integral = std::clamp(integral + error * dt, -limit, limit);
+	}
+	const double gravity = gains.kg * std::cos((angle - gains.horizontal) * M_PI / 18000);
+	const double feedforward = gains.kv * current.velocity + gains.ka * current.acceleration + gravity;
+	const double output = gains.kp * error + gains.ki * integral + gains.kd * (current.velocity - rate) + feedforward;
+	return std::clamp((int) std::lround(output), -max_voltage, max_voltage);
+}
+
+}  // namespace robot
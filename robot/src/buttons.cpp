@@ -0,0 +1,41 @@
+#include "robot/buttons.hpp"
+
+namespace robot {
+
+ButtonEvents ButtonTracker::update(std::uint16_t levels, std::uint32_t now) {
+	ButtonEvents events;
+	events.time = now;
+	if (!started) { // the first update only counts buttons held from here on, nothing is debounced against time 0
+		for (unsigned button = 0; button < count; button++) changed_at[button] = now - settings.debounce_time;
+		started = true;
+	}
+
+	for (unsigned button = 0; button < count; button++) {
+		const std::uint16_t bit = 1u << button;
+		const bool level = levels & bit;
+		const bool down = state & bit;
+
+		if (level != down && now - changed_at[button] >= settings.debounce_time) {
+			changed_at[button] = now;
+			if (level) {
+				state |= bit;
+				events.pressed |= bit;
+				if (tapped[button] && now - pressed_at[button] <= settings.double_tap_time) events.double_tapped |= bit;
+				pressed_at[button] = now;
+				tapped[button] = true;
+				hold_reported &= ~bit;
+			} else {
+				state &= ~bit;
+				events.released |= bit;
+			}
+		}
+
+		if ((state & bit) && !(hold_reported & bit) && now - pressed_at[button] >= settings.hold_time) {
+			events.held |= bit;
+			hold_reported |= bit;
+		}
+	}
+	return events;
+}
+
+}  // namespace robot
@@ -0,0 +1,38 @@
+#include "robot/color_sort.hpp"
+#include <cstdio>
+
+namespace robot {
+
+bool ColorSorter::update(std::uint32_t time, const RingTracker& rings, bool running) {
+	just_resumed = false;
+	if (flinging) {
+		if (time - fling_started < settings.fling_time) return true;
+		flinging = false;
+		just_resumed = true;
+		return false;
+	}
+	if (!running || rejected_color == RingColor::None) return false;
+
+	for (std::size_t i = 0; i < rings.size(); i++) { // oldest, so furthest up, first
+		const RingTracker::Ring& ring = rings.ring(i);
+		if (ring.id <= handled) continue;
+		const double travel = rings.travel(ring);
+		if (travel < settings.eject_at - settings.lead) break; // neither it nor anything behind it is there yet
+		handled = ring.id;
+		if (ring.color != rejected_color) continue; // ours, or never got a good look at it, let it through
+		flinging = true;
+		fling_started = time;
+		count++;
+		latency_ms.add(time - ring.seen);
+		error_degrees.add((std::int32_t) (travel - settings.eject_at));
+		return true;
+	}
+	return false;
+}
+
+int ColorSorter::format(char* buffer, std::size_t size) const {
+	if (rejected_color == RingColor::None) return snprintf(buffer, size, "sorting off");
+	return snprintf(buffer, size, "sorted %u in %d/%d/%d ms late %d", (unsigned) count, (int) latency_ms.min(), (int) latency_ms.mean(), (int) latency_ms.max(), (int) error_degrees.mean());
+}
+
+}  // namespace robot
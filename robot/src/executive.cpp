@@ -0,0 +1,36 @@
+#include "robot/executive.hpp"
+#include <numeric>
+
+namespace robot {
+
+bool Executive::add(const char* name, std::uint32_t period, std::uint32_t phase, Function function, void* context) {
+	if (count == max_subsystems || period == 0 || phase >= period) return false;
+	subsystems[count++] = {name, period, phase, function, context, {}};
+	// the base tick has to land on every subsystem's period and phase
+	base_period = std::gcd(std::gcd(base_period, period), phase);
+	return true;
+}
+
+void Executive::tick(std::uint32_t now) {
+	if (!started) {
+		start = now;
+		started = true;
+	}
+	const std::uint32_t elapsed = now - start;
+	for (std::size_t i = 0; i < count; i++) {
+		Subsystem& subsystem = subsystems[i];
+		if (elapsed % subsystem.period != subsystem.phase) continue;
+
+		const std::uint64_t before = clock();
+		subsystem.function(subsystem.context);
+		const std::uint32_t took = clock() - before;
+
+		Stats& stats = subsystem.stats;
+		stats.runs++;
+		stats.last = took;
+		stats.total += took;
+		if (took > stats.max) stats.max = took;
+	}
+}
+
+}  // namespace robot
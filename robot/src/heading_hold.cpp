@@ -0,0 +1,33 @@
+#include "robot/heading_hold.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace robot {
+
+int HeadingHold::update(std::uint32_t time, double heading, bool holding) {
+	// the sensor only reports every 10 ms, so the rate is filtered over a few readings whatever the loop rate
+	if (started && time != last_time) {
+		const std::uint32_t dt = time - last_time;
+		const double alpha = (double) dt / (settings.filter_time + dt);
+		rate += alpha * ((heading - last_heading) * 1000 / dt - rate);
+	} else if (!started) {
+		rate = 0;
+	}
+	started = true;
+	last_time = time;
+	last_heading = heading;
+
+	if (!holding) {
+		locked = false;
+		return 0;
+	}
+	if (!locked) {
+		if (std::abs(rate) > settings.settle_rate) return 0; // still coming out of a turn
+		locked = true;
+		target = heading;
+	}
+	const double power = (target - heading) * settings.kp - rate * settings.kd;
+	return (int) std::lround(std::clamp(power, -settings.max_power, settings.max_power));
+}
+
+}  // namespace robot
@@ -0,0 +1,98 @@
+#include "robot/ilc.hpp"
+#include "robot/recording.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace robot {
+namespace ilc {
+
+void read_recording(FILE* file, const CurveTables& curves, std::vector<Frame>* commands, std::vector<Frame>* reference, std::uint32_t* period, bool* has_arm) {
+	char line[128]; // a recorded cycle is seven short numbers and at most 12 button letters
+	std::uint32_t header_period = legacy_period;
+	ResponseCurve curve = ResponseCurve::Linear; // what recordings without a header were driven with
+	bool arm = false;
+	while (fgets(line, sizeof(line), file)) {
+		if (parse_header(line, &header_period, &curve)) continue;
+		int dir = 0, turn = 0, angle = 0, left = 0, right = 0, left_power = 0, right_power = 0;
+		// recordings made before the angle and velocity fields existed only fill the first two, the rest stay 0
+		const int fields = sscanf(line, "%d:%d:%d:%d:%d:%d:%d", &dir, &turn, &angle, &left, &right, &left_power, &right_power);
+		if (fields < 2) continue;
+		if (fields >= 3) arm = true;
+		if (fields < 7) { // from before the powers were recorded, work them out from the sticks. Any heading hold is missing from these
+			dir = apply_curve(curves, curve, dir);
+			turn = apply_curve(curves, curve, turn);
+			left_power = dir - turn;
+			right_power = dir + turn;
+		}
+		if (commands) commands->push_back({left_power, right_power, angle});
+		if (reference) reference->push_back({left, right, angle});
+	}
+	if (period) *period = header_period;
+	if (has_arm) *has_arm = arm;
+}
+
+std::vector<Frame> read_frames(FILE* file, int* iteration) {
+	std::vector<Frame> frames;
+	char line[64];
+	while (fgets(line, sizeof(line), file)) {
+		if (line[0] == '#') { // header with the iteration count
+			if (iteration) *iteration = atoi(line + 1);
+			continue;
+		}
+		Frame frame;
+		if (sscanf(line, "%d:%d:%d", &frame.left, &frame.right, &frame.arm) == 3) frames.push_back(frame);
+	}
+	return frames;
+}
+
+void write_frames(FILE* file, const std::vector<Frame>& frames, int iteration) {
+	fprintf(file, "#%d\n", iteration);
+	for (const Frame& frame : frames) {
+		fprintf(file, "%d:%d:%d\n", frame.left, frame.right, frame.arm);
+	}
+}
+
+Error update(const std::vector<Frame>& reference, const std::vector<Frame>& measured, std::vector<Frame>& commands, const Gains& gains) {
+	const size_t n = std::min({reference.size(), measured.size(), commands.size()});
+	Error error = {0, 0};
+	if (n == 0) return error;
+
+	// raw correction for each frame from the error a few frames later, when that frame's command actually shows up on the sensors
+	std::vector<double> left(n), right(n), arm(n);
+	// the leads rounded to whole frames at the recording's period
+	const size_t drive_lead = (gains.drive_lead + gains.period / 2) / gains.period;
+	const size_t arm_lead = (gains.arm_lead + gains.period / 2) / gains.period;
+	for (size_t t = 0; t < n; t++) {
+		const size_t drive_t = std::min(t + drive_lead, n - 1);
+		const size_t arm_t = std::min(t + arm_lead, n - 1);
+		left[t] = gains.drive * (reference[drive_t].left - measured[drive_t].left);
+		right[t] = gains.drive * (reference[drive_t].right - measured[drive_t].right);
+		arm[t] = gains.arm * (reference[arm_t].arm - measured[arm_t].arm);
+
+		const double left_error = reference[t].left - measured[t].left;
+		const double right_error = reference[t].right - measured[t].right;
+		const double arm_error = reference[t].arm - measured[t].arm;
+		error.drive += left_error * left_error + right_error * right_error;
+		error.arm += arm_error * arm_error;
+	}
+	error.drive = std::sqrt(error.drive / (2 * n));
+	error.arm = std::sqrt(error.arm / n);
+
+	// smooth the correction with a [1 2 1] filter so sensor noise isn't learned into the commands and the iterations stay stable
+	auto smooth = [n](const std::vector<double>& raw, size_t t) {
+		const double before = raw[t == 0 ? 0 : t - 1];
+		const double after = raw[t + 1 == n ? t : t + 1];
+		return (before + 2 * raw[t] + after) / 4;
+	};
+	for (size_t t = 0; t < n; t++) {
+		Frame& command = commands[t];
+		command.left = std::clamp((int) std::lround(command.left + smooth(left, t)), -gains.drive_limit, gains.drive_limit);
+		command.right = std::clamp((int) std::lround(command.right + smooth(right, t)), -gains.drive_limit, gains.drive_limit);
+		command.arm = (int) std::lround(command.arm + smooth(arm, t));
+	}
+	return error;
+}
+
+}  // namespace ilc
+}  // namespace robot
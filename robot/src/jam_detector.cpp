@@ -0,0 +1,50 @@
+#include "robot/jam_detector.hpp"
+#include <cmath>
+
+namespace robot {
+
+bool JamDetector::update(std::uint32_t time, bool running, int current, double velocity, double torque) {
+	// first order low pass filters, weighted by the time since the last reading so the loop rate doesn't matter
+	const std::uint32_t dt = started ? time - last_time : settings.filter_time;
+	const double alpha = (double) dt / (settings.filter_time + dt);
+	this->current += alpha * (std::abs(current) - this->current);
+	this->velocity += alpha * (std::abs(velocity) - this->velocity);
+	this->torque += alpha * (std::abs(torque) - this->torque);
+	started = true;
+	last_time = time;
+	just_resumed = false;
+
+	if (!running) { // stopped or reversed by the driver, whatever was happening is over
+		was_running = false;
+		stalled = false;
+		reversing = false;
+		return false;
+	}
+	if (!was_running) running_since = time;
+	was_running = true;
+
+	if (reversing) {
+		if (time - reversing_since < settings.reverse_time) return true;
+		reversing = false;
+		just_resumed = true;
+		running_since = time;
+		stalled = false;
+		return false;
+	}
+
+	const bool stalling = this->current >= settings.current && this->velocity <= settings.velocity && this->torque >= settings.torque;
+	if (!stalling || time - running_since < settings.start_time) {
+		stalled = false;
+		return false;
+	}
+	if (!stalled) stalled_since = time;
+	stalled = true;
+	if (time - stalled_since < settings.detect_time) return false;
+
+	reversing = true;
+	reversing_since = time;
+	count++;
+	return true;
+}
+
+}  // namespace robot
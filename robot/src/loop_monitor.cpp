@@ -0,0 +1,59 @@
+#include "robot/loop_monitor.hpp"
+
+namespace robot {
+
+void Histogram::add(std::int32_t value) {
+	std::int32_t bucket = value < low ? 0 : (std::int32_t) ((std::uint32_t) (value - low) / width);
+	if (bucket >= (std::int32_t) buckets) bucket = buckets - 1;
+	counts[bucket]++;
+	if (total_count == 0 || value < min_value) min_value = value;
+	if (total_count == 0 || value > max_value) max_value = value;
+	total_count++;
+	sum += value;
+}
+
+LoopMonitor::LoopMonitor(std::uint32_t period)
+    : period(period),
+      period_histogram((std::int32_t) (period - period / 4), period / (2 * Histogram::buckets)),
+      execution_histogram(0, period / Histogram::buckets) {}
+
+void LoopMonitor::begin(std::uint64_t now) {
+	if (started) period_histogram.add((std::int32_t) (now - last_begin));
+	last_begin = now;
+	started = true;
+}
+
+void LoopMonitor::end(std::uint64_t now) {
+	const std::uint32_t took = now - last_begin;
+	execution_histogram.add((std::int32_t) took);
+	if (took > period) overrun_count++;
+}
+
+int LoopMonitor::format_period(char* buffer, std::size_t size) const {
+	return snprintf(buffer, size, "period %d/%d/%d us", (int) period_histogram.min(), (int) period_histogram.mean(), (int) period_histogram.max());
+}
+
+int LoopMonitor::format_execution(char* buffer, std::size_t size) const {
+	return snprintf(buffer, size, "exec %d/%d/%d us over %u", (int) execution_histogram.min(), (int) execution_histogram.mean(), (int) execution_histogram.max(), (unsigned) overrun_count);
+}
+
+void LoopMonitor::dump(FILE* file) const {
+	char line[64];
+	fprintf(file, "target period %u us, %u overruns\n", (unsigned) period, (unsigned) overrun_count);
+	format_period(line, sizeof(line));
+	fprintf(file, "%s (min/mean/max)\n", line);
+	format_execution(line, sizeof(line));
+	fprintf(file, "%s (min/mean/max)\n", line);
+
+	const Histogram* histograms[] = {&period_histogram, &execution_histogram};
+	const char* names[] = {"period", "execution"};
+	for (int h = 0; h < 2; h++) {
+		fprintf(file, "%s histogram:\n", names[h]);
+		for (std::size_t bucket = 0; bucket < Histogram::buckets; bucket++) {
+			fprintf(file, "  %s%6d us  %u\n", bucket == 0 ? "<=" : bucket == Histogram::buckets - 1 ? ">=" : "  ",
+			        (int) histograms[h]->bucket_start(bucket), (unsigned) histograms[h]->count(bucket));
+		}
+	}
+}
+
+}  // namespace robot
@@ -0,0 +1,60 @@
+#include "robot/motion_profile.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace robot {
+
+TrapezoidProfile::TrapezoidProfile(double start, double goal, double max_velocity, double max_acceleration, double start_velocity) : start(start) {
+	direction = goal >= start ? 1 : -1;
+	distance = std::abs(goal - start);
+	max_velocity = std::abs(max_velocity);
+	max_acceleration = std::abs(max_acceleration);
+	if (distance == 0 || max_velocity == 0 || max_acceleration == 0) return; // already there, or nothing it can do
+	this->start_velocity = std::clamp(start_velocity * direction, 0.0, max_velocity);
+	const double v0 = this->start_velocity;
+	acceleration = deceleration = max_acceleration;
+
+	const double stopping = v0 * v0 / (2 * max_acceleration);
+	if (stopping >= distance) { // too fast to stop in time at the limit, brake harder
+		peak_velocity = v0;
+		deceleration = v0 * v0 / (2 * distance);
+		decelerating = v0 / deceleration;
+		return;
+	}
+	// the highest speed it could reach and still stop on the goal
+	peak_velocity = std::min(max_velocity, std::sqrt(max_acceleration * distance + v0 * v0 / 2));
+	accelerating = (peak_velocity - v0) / max_acceleration;
+	decelerating = peak_velocity / max_acceleration;
+	const double ramps = (peak_velocity * peak_velocity - v0 * v0) / (2 * max_acceleration) + peak_velocity * peak_velocity / (2 * max_acceleration);
+	cruising = std::max(0.0, (distance - ramps) / peak_velocity);
+}
+
+Setpoint TrapezoidProfile::sample(double time) const {
+	double position, velocity, accel;
+	if (time <= 0) {
+		position = 0;
+		velocity = start_velocity;
+		accel = 0;
+	} else if (time < accelerating) {
+		position = start_velocity * time + acceleration * time * time / 2;
+		velocity = start_velocity + acceleration * time;
+		accel = acceleration;
+	} else if (time < accelerating + cruising) {
+		const double t = time - accelerating;
+		position = (start_velocity + peak_velocity) / 2 * accelerating + peak_velocity * t;
+		velocity = peak_velocity;
+		accel = 0;
+	} else if (time < duration()) {
+		const double left = duration() - time; // mirror of the start of a stop from the goal
+		position = distance - deceleration * left * left / 2;
+		velocity = deceleration * left;
+		accel = -deceleration;
+	} else {
+		position = distance;
+		velocity = 0;
+		accel = 0;
+	}
+	return {start + direction * position, direction * velocity, direction * accel};
+}
+
+}  // namespace robot
@@ -0,0 +1,73 @@
+// the probe table behind ROBOT_PROBE and profile::time, with the probes on whatever the program's flags
+#define ROBOT_PROFILE
+#include "robot/profile.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace robot::profile {
+namespace {
+
+Clock clock = nullptr;
+Probe probes[max_probes]; // the last one collects everything that doesnt fit
+std::atomic<std::size_t> count{0}; // slots handed out, a task can be preempted between claiming one and naming it
+
+std::size_t used() { return std::min(count.load(), max_probes - 1); }
+
+}  // namespace
+
+void init(Clock source) { clock = source; }
+
+Probe* probe(const char* name, bool timed) {
+	for (std::size_t i = 0; i < used(); i++) {
+		if (probes[i].name && std::strcmp(probes[i].name, name) == 0) return &probes[i];
+	}
+	const std::size_t index = count++;
+	if (index >= max_probes - 1) {
+		probes[max_probes - 1].timed = true;
+		probes[max_probes - 1].name = "(other)";
+		return &probes[max_probes - 1];
+	}
+	probes[index].timed = timed;
+	probes[index].name = name;
+	return &probes[index];
+}
+
+std::uint64_t now() { return clock ? clock() : 0; }
+
+void record(Probe* probe, std::uint32_t took) {
+	if (probe->count == 0 || took < probe->min) probe->min = took;
+	if (took > probe->max) probe->max = took;
+	probe->count++;
+	probe->total += took;
+}
+
+std::size_t size() { return used() + (probes[max_probes - 1].name ? 1 : 0); }
+
+const Probe& at(std::size_t index) { return index < used() ? probes[index] : probes[max_probes - 1]; }
+
+int format(char* buffer, std::size_t size, const Probe& probe) {
+	if (!probe.timed) return snprintf(buffer, size, "%s %ux", probe.name, (unsigned) probe.count);
+	return snprintf(buffer, size, "%s %ux %u/%u/%u us", probe.name, (unsigned) probe.count, (unsigned) probe.min, (unsigned) probe.mean(), (unsigned) probe.max);
+}
+
+void dump(FILE* file) {
+	char line[80];
+	fprintf(file, "probe count min/mean/max\n");
+	for (std::size_t i = 0; i < size(); i++) {
+		if (at(i).name == nullptr) continue; // still being added
+		format(line, sizeof(line), at(i));
+		fprintf(file, "%s\n", line);
+	}
+}
+
+void reset() {
+	for (Probe& probe : probes) {
+		probe.count = 0;
+		probe.min = 0;
+		probe.max = 0;
+		probe.total = 0;
+	}
+}
+
+}  // namespace robot::profile
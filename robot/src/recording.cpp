@@ -0,0 +1,53 @@
+#include "robot/recording.hpp"
+#include <cstdio>
+#include <cstring>
+
+namespace robot {
+
+int format_header(char* buffer, std::size_t size, std::uint32_t period, ResponseCurve curve) {
+	return snprintf(buffer, size, "#period %u curve %u\n", (unsigned) period, (unsigned) curve);
+}
+
+bool parse_header(const char* line, std::uint32_t* period, ResponseCurve* curve) {
+	unsigned value, id = 0; // headers from before the curve was added leave it linear
+	if (sscanf(line, "#period %u curve %u", &value, &id) < 1 || value == 0) return false;
+	*period = value;
+	// a curve this build doesn't have can't be replayed faithfully either way, linear at least drives
+	if (curve) *curve = id < static_cast<unsigned>(ResponseCurve::Count) ? static_cast<ResponseCurve>(id) : ResponseCurve::Linear;
+	return true;
+}
+
+int format_cycle(char* buffer, std::size_t size, const RecordedCycle& cycle) {
+	const Inputs& in = cycle.in;
+	char buttons[13];
+	int count = 0;
+	if (in.a) buttons[count++] = 'a';
+	if (in.b) buttons[count++] = 'b';
+	if (in.r1) buttons[count++] = 'r';
+	if (in.l1) buttons[count++] = 'l';
+	if (in.x) buttons[count++] = 'x';
+	if (in.y) buttons[count++] = 'y';
+	if (in.l2) buttons[count++] = 'L';
+	if (in.r2) buttons[count++] = 'R';
+	if (in.up) buttons[count++] = '^';
+	if (in.down) buttons[count++] = 'v';
+	if (in.left) buttons[count++] = '<';
+	if (in.right) buttons[count++] = '>';
+	buttons[count] = '\0';
+	return snprintf(buffer, size, "%d:%d:%d:%d:%d:%d:%d%s\n", in.dir, in.turn, in.arm_angle, cycle.left_velocity, cycle.right_velocity, cycle.left_power, cycle.right_power, buttons);
+}
+
+std::uint16_t parse_buttons(const char* line) {
+	// the letter of each Button in order
+	static constexpr char letters[] = {'l', 'L', 'r', 'R', '^', 'v', '<', '>', 'x', 'b', 'y', 'a'};
+	static_assert(sizeof(letters) == static_cast<std::size_t>(Button::Count));
+
+	std::uint16_t buttons = 0;
+	for (unsigned button = 0; button < sizeof(letters); button++) {
+		// everything but the buttons are numbers, '-' and ':', so a letter anywhere in the line means it was held
+		if (letters[button] && std::strchr(line, letters[button])) buttons |= 1u << button;
+	}
+	return buttons;
+}
+
+}  // namespace robot
@@ -0,0 +1,78 @@
+#include "robot/ring_tracker.hpp"
+#include <cmath>
+#include <cstdlib>
+
+namespace robot {
+
+const char* name(RingColor color) {
+	switch (color) {
+		case RingColor::Red: return "red";
+		case RingColor::Blue: return "blue";
+		default: return "none";
+	}
+}
+
+static double hue_distance(double a, double b) { // around the color wheel, 350 is 20 from 10
+	const double distance = std::fmod(std::abs(a - b), 360);
+	return distance > 180 ? 360 - distance : distance;
+}
+
+RingColor classify(double hue, int proximity, const RingSettings& settings) {
+	if (proximity < settings.proximity) return RingColor::None; // nothing close enough to be a ring, just the field
+	if (hue_distance(hue, settings.red_hue) <= settings.hue_tolerance) return RingColor::Red;
+	if (hue_distance(hue, settings.blue_hue) <= settings.hue_tolerance) return RingColor::Blue;
+	return RingColor::None;
+}
+
+void RingTracker::update(std::uint32_t time, double position, int proximity, double hue, int current) {
+	const double last = started ? this->position : position;
+	const std::uint32_t dt = started ? time - last_time : settings.current_time;
+	this->position = position;
+	last_time = time;
+	started = true;
+	arrivals = 0;
+
+	if (proximity >= 0) { // a ring in front of the optical sensor, with some hysteresis so one ring is one entry
+		const bool now_near = near ? proximity >= settings.proximity * 3 / 4 : proximity >= settings.proximity;
+		if (now_near && !near) enter();
+		near = now_near;
+		if (near && count > 0 && rings[count - 1].color == RingColor::None) { // the first good look at the newest ring decides its color
+			rings[count - 1].color = classify(hue, proximity, settings);
+			rings[count - 1].seen = time;
+		}
+	} else { // no optical sensor, a ring getting picked up makes the motor pull harder for a moment
+		const bool spike = std::abs(current) - this->current >= settings.current_spike;
+		if (spike && !spiking) enter();
+		spiking = spike;
+	}
+	// weighted by the time since the last update, like the jam detector's filters, so the loop rate doesn't matter
+	this->current += (double) dt / (settings.current_time + dt) * (std::abs(current) - this->current);
+
+	std::size_t kept = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		const Ring ring = rings[i];
+		const double before = last - ring.entered;
+		const double after = position - ring.entered;
+		for (std::size_t mark = 0; mark < static_cast<std::size_t>(RingMark::Count); mark++) {
+			const double at = settings.marks[mark];
+			if (before < at && after >= at) {
+				arrivals |= 1u << mark;
+				arrival_ids[mark] = ring.id;
+			}
+		}
+		const bool gone = after >= settings.marks[static_cast<std::size_t>(RingMark::Top)] || after < -settings.spacing; // off the top, or back out the bottom
+		if (!gone) rings[kept++] = ring;
+	}
+	count = kept;
+}
+
+void RingTracker::enter() {
+	if (count > 0 && position - rings[count - 1].entered < settings.spacing) return; // still the last ring
+	if (count == max_rings) { // lost track of the oldest somehow, make room
+		for (std::size_t i = 1; i < count; i++) rings[i - 1] = rings[i];
+		count--;
+	}
+	rings[count++] = {next_id++, position, RingColor::None, 0};
+}
+
+}  // namespace robot
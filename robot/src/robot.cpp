@@ -0,0 +1,120 @@
+#include "robot/robot.hpp"
+#include <cstdlib>
+
+namespace robot {
+
+template <typename Config>
+Commands BasicRobot<Config>::step(const Inputs& in) {
+	Commands out;
+	drive(in, out);
+	conveyor(in, out);
+	clamp(in, out);
+	arm(in, out);
+	return out;
+}
+
+template <typename Config>
+void BasicRobot<Config>::drive(const Inputs& in, Commands& out) {
+	// arcade control scheme on the shaped sticks, unless replay or the sequencer already worked out the powers
+	const int dir = apply_curve(curves, curve, in.dir);
+	int turn = apply_curve(curves, curve, in.turn);
+	if (in.has_heading) { // driving with the turn stick in its deadband holds the heading instead of drifting
+		// replayed powers were recorded after the hold, so they already steer it. Holding again would count it twice
+		turn += heading_hold.update(in.time, in.heading, !in.has_drive && turn == 0 && dir != 0);
+	} else {
+		heading_hold.reset();
+	}
+	const int left = in.has_drive ? in.drive_left : dir - turn;
+	const int right = in.has_drive ? in.drive_right : dir + turn;
+	requested_left = left;
+	requested_right = right;
+	// eased there rather than jumped to, so a stick reversal doesnt spike the current or spin the wheels
+	out.left = left_slew.update(in.time, left, in.left_current);
+	out.right = right_slew.update(in.time, right, in.right_current);
+}
+
+template <typename Config>
+void BasicRobot<Config>::conveyor(const Inputs& in, Commands& out) {
+	ring_tracker.update(in.time, in.conveyor_position, in.ring_proximity, in.ring_hue, in.conveyor_current);
+	if (in.has_conveyor) { // a scripted step, sent every cycle like a held button so jams and sorting still get their way
+		out.conveyor = in.conveyor_command == 0 ? ConveyorCommand{ConveyorCommand::Brake, 0} : ConveyorCommand{ConveyorCommand::Move, in.conveyor_command};
+		conveyor_moving = false; // the routine decides when it stops, not a ring reaching the arm
+	} else if (in.b && in.conveyor_power > Config::conveyor_moving_power) { // stop takes priority over everything while the conveyor is powered
+		out.conveyor = {ConveyorCommand::Brake, 0};
+		conveyor_moving = false;
+	} else if (in.a) { // full speed
+		out.conveyor = {ConveyorCommand::Move, Config::conveyor_power};
+		conveyor_moving = true;
+	} else if (in.r1) { // slower forward for fixing issues mid run
+		out.conveyor = {ConveyorCommand::Voltage, Config::conveyor_slow_voltage};
+		conveyor_moving = false;
+	} else if (in.l1) { // slower reverse
+		out.conveyor = {ConveyorCommand::Voltage, -Config::conveyor_slow_voltage};
+		conveyor_moving = false;
+	} else if (std::abs(in.conveyor_current) <= Config::conveyor_idle_current && !conveyor_moving) {
+		// stops the conveyor after r1/l1 are let go, without stopping a full speed run from a
+		out.conveyor = {ConveyorCommand::Brake, 0};
+	}
+	if (ring_tracker.reached(RingMark::Arm) && conveyor_moving && preset == ArmPreset::Load && state == ArmState::AtPreset && !in.a) {
+		// a full speed run stops with the ring sitting on the loaded arm, a to carry on past it
+		out.conveyor = {ConveyorCommand::Brake, 0};
+		conveyor_moving = false;
+	}
+
+	if (out.conveyor.mode != ConveyorCommand::Keep) { // Keep leaves it doing whatever it was
+		conveyor_forward = out.conveyor.mode != ConveyorCommand::Brake && out.conveyor.value > 0;
+		if (conveyor_forward) running = out.conveyor;
+	}
+	const bool flinging = sorter.update(in.time, ring_tracker, conveyor_forward);
+	// a stop to fling a ring isnt a stall, and the restart after it is a spin up
+	if (jam.update(in.time, conveyor_forward && !flinging, in.conveyor_current, in.conveyor_velocity, in.conveyor_torque)) { // stalled on a ring, back it out
+		out.conveyor = {ConveyorCommand::Voltage, -Config::jam_reverse_voltage};
+	} else if (flinging) { // the wrong color ring is at the eject point, stop so it flies off
+		out.conveyor = {ConveyorCommand::Brake, 0};
+	} else if (jam.resumed() || sorter.resumed()) { // and carry on with what it was doing
+		out.conveyor = running;
+	}
+}
+
+template <typename Config>
+void BasicRobot<Config>::clamp(const Inputs& in, Commands& out) {
+	if (in.clamp_toggle) { // one toggle per debounced press, see buttons.hpp
+		clamped = !clamped;
+	}
+	out.clamp = clamped;
+}
+
+template <typename Config>
+void BasicRobot<Config>::arm(const Inputs& in, Commands& out) {
+	if (in.arm_preset >= 0) { // straight there from wherever the arm is, even halfway to another preset
+		preset = static_cast<ArmPreset>(in.arm_preset);
+		state = ArmState::Moving;
+	} else if (in.l2 || in.r2) { // the driver taking over interrupts any preset
+		state = ArmState::Manual;
+	} else if (state == ArmState::Manual) { // and letting go leaves it where it is
+		state = ArmState::Holding;
+	}
+	const int target = Config::arm_presets[static_cast<std::size_t>(preset)];
+	if (state == ArmState::Moving && std::abs(target - in.arm_angle) <= Config::arm_tolerance) state = ArmState::AtPreset;
+
+	if (in.has_arm_target && (state == ArmState::Holding || state == ArmState::Manual)) {
+		// a recorded or scripted angle, for when no preset is active. A replay's presets come from the recorded buttons instead.
+		out.arm = {ArmCommand::Target, in.arm_target};
+		return;
+	}
+	switch (state) {
+		case ArmState::Holding: out.arm = {ArmCommand::Hold, 0}; break; // holding brakes keep the arm from falling when it is in the air
+		case ArmState::Manual: out.arm = {ArmCommand::Move, in.l2 ? -Config::arm_manual_power : Config::arm_manual_power}; break;
+		case ArmState::Moving:
+		case ArmState::AtPreset: out.arm = {ArmCommand::Target, target}; break; // the arm controller profiles the move and holds it there
+	}
+}
+
+const char* name(ArmPreset preset) {
+	static const char* const names[] = {"stow", "load", "prime", "score", "descore"};
+	return preset < ArmPreset::Count ? names[static_cast<std::size_t>(preset)] : "?";
+}
+
+template class BasicRobot<RobotConfig>;
+
+}  // namespace robot
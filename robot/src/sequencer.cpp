@@ -0,0 +1,218 @@
+#include "robot/sequencer.hpp"
+#include <algorithm>
+#include <cmath>
+#include <new>
+
+namespace robot::auton {
+
+namespace {
+
+// coroutine frames, handed out and returned on the task running the routine only
+constexpr std::size_t frame_size = 512;
+constexpr std::size_t frame_count = 16;
+alignas(std::max_align_t) unsigned char frames[frame_count][frame_size];
+bool frame_used[frame_count];
+
+Sequencer* running = nullptr; // the one inside tick
+
+}  // namespace
+
+void* Routine::promise_type::operator new(std::size_t size) {
+	if (size <= frame_size) {
+		for (std::size_t i = 0; i < frame_count; i++) {
+			if (!frame_used[i]) {
+				frame_used[i] = true;
+				return frames[i];
+			}
+		}
+	}
+	return ::operator new(size); // a frame too big for the pool, or too many steps at once
+}
+
+void Routine::promise_type::operator delete(void* frame, std::size_t) { // the address alone says which pool slot it is
+	unsigned char* const bytes = static_cast<unsigned char*>(frame);
+	if (bytes >= &frames[0][0] && bytes < &frames[0][0] + sizeof(frames)) {
+		frame_used[(bytes - &frames[0][0]) / frame_size] = false;
+	} else {
+		::operator delete(frame);
+	}
+}
+
+Routine& Routine::operator=(Routine&& other) {
+	if (this != &other) {
+		if (handle) handle.destroy();
+		handle = other.handle;
+		other.handle = nullptr;
+	}
+	return *this;
+}
+
+Routine::~Routine() {
+	if (handle) handle.destroy(); // takes any step it is awaiting with it
+}
+
+void Routine::start() {
+	if (!done()) handle.resume();
+}
+
+bool Until::await_ready() const {
+	return condition(Sequencer::active(), context);
+}
+
+void Until::await_suspend(std::coroutine_handle<> awaiting) const {
+	Sequencer::active().wait(condition, context, awaiting);
+}
+
+void Sequencer::start(Routine routine) {
+	waiting_count = 0; // anything still waiting belongs to the old routine, which goes with this
+	this->routine = static_cast<Routine&&>(routine);
+	started = false;
+	driving = false;
+	has_arm_target = false;
+	has_conveyor = false;
+	has_clamp = false;
+}
+
+void Sequencer::tick(std::uint32_t time, Inputs& in) {
+	running = this;
+	now = time;
+	if (!started) { // measure from where the robot is when the routine begins
+		origin_left = in.left_position;
+		origin_right = in.right_position;
+	}
+	left = in.left_position - origin_left;
+	right = in.right_position - origin_right;
+	arm_angle = in.arm_angle;
+
+	if (!started) {
+		started = true;
+		routine.start();
+	}
+	// a step finishing can let another one finish this same tick, so keep going
+	// until nothing moves. The bound only stops a step that never suspends.
+	for (std::size_t pass = 0; pass < 4 * max_waiting; pass++) {
+		bool resumed = false;
+		for (std::size_t i = 0; i < waiting_count;) {
+			if (!waiting[i].condition(*this, waiting[i].context)) {
+				i++;
+				continue;
+			}
+			const std::coroutine_handle<> awaiting = waiting[i].awaiting;
+			std::copy(waiting + i + 1, waiting + waiting_count, waiting + i); // keep the order steps were started in
+			waiting_count--;
+			awaiting.resume(); // can add to waiting
+			resumed = true;
+		}
+		if (!resumed) break;
+	}
+
+	if (has_arm_target) { // Robot::arm follows it like a replayed angle
+		in.has_arm_target = true;
+		in.arm_target = arm_target;
+	}
+	if (has_conveyor) { // Robot::conveyor runs it, so jams and sorting still work
+		in.has_conveyor = true;
+		in.conveyor_command = conveyor_power;
+	}
+	in.has_drive = true; // and Robot::drive eases into these like replayed drive commands, stopped when no step is driving
+	in.drive_left = 0;
+	in.drive_right = 0;
+	if (driving) {
+		const double power = std::clamp((drive_target - position()) * settings.drive_kp, (double) -drive_power, (double) drive_power);
+		const double correction = (left - right) * settings.straight_kp; // slow the side that is ahead
+		in.drive_left = std::clamp((int) std::lround(power - correction), -127, 127);
+		in.drive_right = std::clamp((int) std::lround(power + correction), -127, 127);
+	}
+	running = nullptr;
+}
+
+void Sequencer::apply(Commands& out) const {
+	if (has_clamp) out.clamp = clamped;
+}
+
+Sequencer& Sequencer::active() {
+	return *running;
+}
+
+void Sequencer::wait(Condition condition, const void* context, std::coroutine_handle<> awaiting) {
+	if (waiting_count == max_waiting) std::terminate(); // more steps at once than a routine should ever have
+	waiting[waiting_count++] = {condition, context, awaiting};
+}
+
+void Sequencer::drive(double target, int power) {
+	driving = true;
+	drive_target = target;
+	drive_power = std::abs(power);
+	// both sides measure from here, so straight_kp keeps this heading
+	origin_left += left - position();
+	origin_right += right - position();
+	left = right = position();
+}
+
+void Sequencer::arm(int target) {
+	has_arm_target = true;
+	arm_target = target;
+}
+
+void Sequencer::conveyor(int power) {
+	has_conveyor = true;
+	conveyor_power = power;
+}
+
+void Sequencer::clamp(bool clamped) {
+	has_clamp = true;
+	this->clamped = clamped;
+}
+
+bool Sequencer::drive_settled() const {
+	return std::abs(drive_target - position()) <= settings.drive_tolerance;
+}
+
+bool Sequencer::arm_settled() const {
+	return std::abs(arm_target - arm_angle) <= settings.arm_tolerance;
+}
+
+Routine drive_to(double position, int power) {
+	Sequencer& sequencer = Sequencer::active();
+	sequencer.drive(position, power);
+	co_await Until{[](const Sequencer& s, const void*) { return s.drive_settled(); }};
+	sequencer.stop_drive();
+}
+
+Routine arm_to(int angle) {
+	Sequencer::active().arm(angle);
+	co_await Until{[](const Sequencer& s, const void*) { return s.arm_settled(); }};
+}
+
+Routine arm_to(ArmPreset preset) {
+	co_await arm_to(Sequencer::active().preset_angle(preset)); // a coroutine so active() is only asked once this runs inside tick
+}
+
+Routine wait(std::uint32_t ms) {
+	const std::uint32_t end = Sequencer::active().time() + ms;
+	co_await Until{[](const Sequencer& s, const void* end) { return (std::int32_t) (s.time() - *static_cast<const std::uint32_t*>(end)) >= 0; }, &end};
+}
+
+Routine conveyor(int power) {
+	Sequencer::active().conveyor(power);
+	co_return;
+}
+
+Routine clamp(bool clamped) {
+	Sequencer::active().clamp(clamped);
+	co_return;
+}
+
+void start_all(const Group& group) {
+	for (std::size_t i = 0; i < group.size; i++) group.steps[i]->start();
+}
+
+bool all_done(const Sequencer&, const void* group) {
+	const Group& steps = *static_cast<const Group*>(group);
+	for (std::size_t i = 0; i < steps.size; i++) {
+		if (!steps.steps[i]->done()) return false;
+	}
+	return true;
+}
+
+}  // namespace robot::auton
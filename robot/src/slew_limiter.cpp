@@ -0,0 +1,36 @@
+#include "robot/slew_limiter.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace robot {
+
+namespace {
+
+double toward(double from, double to, double step) {
+	return from < to ? std::min(from + step, to) : std::max(from - step, to);
+}
+
+}  // namespace
+
+int SlewLimiter::update(std::uint32_t time, int target, int current) {
+	// the first update has nothing to measure from, the robot starts out stopped anyway
+	const double dt = started ? std::min(time - last_time, settings.max_step) / 1000.0 : 0;
+	started = true;
+	last_time = time;
+
+	const bool same_way = (target > 0) == (output > 0) && (target < 0) == (output < 0);
+	if (output != 0 && (!same_way || std::abs(target) < std::abs(output))) { // slowing down
+		output = toward(output, same_way ? target : 0, settings.decel * dt); // a reversal stops at zero first
+	} else {
+		const double over = (std::abs(current) - settings.soft_current) / (settings.hard_current - settings.soft_current);
+		const double scale = std::clamp(1 - over * (1 - settings.min_scale), settings.min_scale, 1.0);
+		output = toward(output, target, settings.accel * scale * dt);
+	}
+	return power();
+}
+
+int SlewLimiter::power() const {
+	return (int) std::lround(output);
+}
+
+}  // namespace robot
@@ -0,0 +1,32 @@
+#include "robot/snapshot.hpp"
+#include "robot/buttons.hpp"
+
+namespace robot {
+
+Inputs controls(const Snapshot& snapshot, const ButtonEvents& events) {
+	Inputs in;
+	in.time = snapshot.time;
+	in.dir = -snapshot.left_y; // forward/backward from the left stick
+	in.turn = snapshot.right_x; // turn left/right from the right stick
+	in.a = snapshot.held(Button::A); // conveyor start
+	in.b = snapshot.held(Button::B); // conveyor stop
+	in.r1 = snapshot.held(Button::R1); // conveyor slow forward
+	in.l1 = snapshot.held(Button::L1); // conveyor slow reverse
+	in.x = snapshot.held(Button::X); // clamp
+	in.clamp_toggle = events.was_pressed(Button::X); // toggles once per press
+	in.y = snapshot.held(Button::Y); // arm presets
+	in.up = snapshot.held(Button::Up);
+	in.down = snapshot.held(Button::Down);
+	in.left = snapshot.held(Button::Left);
+	in.right = snapshot.held(Button::Right);
+	if (events.was_pressed(Button::Y)) in.arm_preset = static_cast<int>(ArmPreset::Load); // each goes once per press
+	else if (events.was_pressed(Button::Down)) in.arm_preset = static_cast<int>(ArmPreset::Stow);
+	else if (events.was_pressed(Button::Right)) in.arm_preset = static_cast<int>(ArmPreset::Prime);
+	else if (events.was_pressed(Button::Up)) in.arm_preset = static_cast<int>(ArmPreset::Score);
+	else if (events.was_pressed(Button::Left)) in.arm_preset = static_cast<int>(ArmPreset::Descore);
+	in.l2 = snapshot.held(Button::L2); // arm reverse
+	in.r2 = snapshot.held(Button::R2); // arm forward
+	return in;
+}
+
+}  // namespace robot
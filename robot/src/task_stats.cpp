@@ -0,0 +1,33 @@
+#include "robot/task_stats.hpp"
+#include <cstdio>
+
+namespace robot {
+
+__attribute__((noinline)) std::uint32_t* paint_stack(std::size_t bytes) {
+	volatile std::uint32_t marker = 0;
+	// start a little below this frame so none of it gets painted over. The
+	// addresses are worked out as integers since they are outside any object.
+	const std::uintptr_t top = (reinterpret_cast<std::uintptr_t>(&marker) - 64) & ~(std::uintptr_t) 3;
+	const std::uintptr_t bottom = top - bytes / sizeof(std::uint32_t) * sizeof(std::uint32_t);
+	for (std::uintptr_t address = bottom; address < top; address += sizeof(std::uint32_t)) {
+		*reinterpret_cast<volatile std::uint32_t*>(address) = stack_paint;
+	}
+	return reinterpret_cast<std::uint32_t*>(bottom);
+}
+
+std::size_t unused_stack(const std::uint32_t* bottom, std::size_t bytes) {
+	const volatile std::uint32_t* word = bottom;
+	const std::size_t words = bytes / sizeof(std::uint32_t);
+	std::size_t unused = 0;
+	while (unused < words && word[unused] == stack_paint) unused++;
+	return unused * sizeof(std::uint32_t);
+}
+
+int format_task(char* buffer, std::size_t size, const TaskStats& task) {
+	static const char* const states[] = {"running", "ready", "blocked", "suspended", "deleted", "invalid"};
+	const char* state = task.state < sizeof(states) / sizeof(states[0]) ? states[task.state] : "?";
+	return snprintf(buffer, size, "%s %s p%u stack %u/%u free cpu %u%% starved %u", task.name, state, (unsigned) task.priority,
+	                (unsigned) task.stack_unused, (unsigned) task.stack_size, (unsigned) task.cpu(), (unsigned) task.starved);
+}
+
+}  // namespace robot
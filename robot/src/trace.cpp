@@ -0,0 +1,177 @@
+// the event ring buffer and the trace.bin format, which trace_to_json reads back on Linux
+#define ROBOT_TRACE
+#include "robot/trace.hpp"
+#include <atomic>
+#include <cstring>
+
+namespace robot::trace {
+
+bool read_header(FILE* file) {
+	Header header;
+	const Header expected;
+	return fread(&header, sizeof(header), 1, file) == 1 && std::memcmp(header.magic, expected.magic, sizeof(header.magic)) == 0 && header.version == expected.version;
+}
+
+bool read_record(FILE* file, Record* record, char* text, std::size_t size) {
+	if (fread(record, sizeof(*record), 1, file) != 1) return false;
+	if (size) text[0] = '\0';
+	if (record->kind != Kind::Name) return true;
+
+	// names longer than text are cut short but still skipped over whole
+	for (std::int32_t i = 0; i < record->value; i++) {
+		const int c = fgetc(file);
+		if (c == EOF) return false;
+		if ((std::size_t) i + 1 < size) {
+			text[i] = c;
+			text[i + 1] = '\0';
+		}
+	}
+	return true;
+}
+
+namespace {
+
+static_assert((capacity & (capacity - 1)) == 0, "trace capacity must be a power of two");
+
+// any task can add records: each one claims a slot by bumping head, fills it
+// and then publishes it by setting the slot's sequence. flush() reads slots in
+// order and stops at the first that isn't published yet.
+struct Slot {
+	std::atomic<std::uint32_t> sequence{0}; // the claim number + 1 once the record is written
+	Record record;
+};
+Slot slots[capacity];
+std::atomic<std::uint32_t> head{0}; // next slot to claim
+std::atomic<std::uint32_t> tail{0}; // next slot to flush, only flush() stores
+std::atomic<std::uint32_t> dropped_count{0};
+
+struct Name {
+	std::atomic<bool> ready{false};
+	const char* text = nullptr;
+};
+Name names[max_names];
+std::atomic<std::size_t> name_count{0};
+std::size_t names_written = 0; // only flush() touches it
+bool header_written = false;
+
+// task name pointers stay the same for the life of a task, so they are
+// matched by address without comparing text
+constexpr std::size_t max_tasks = 16;
+struct Task {
+	std::atomic<const char*> name{nullptr};
+	std::uint16_t id = 0;
+	std::atomic<bool> ready{false};
+};
+Task tasks[max_tasks];
+
+Clock clock = nullptr;
+TaskName task_name = nullptr;
+std::uint64_t start = 0;
+
+std::uint16_t task_id() {
+	const char* name = task_name ? task_name() : nullptr;
+	if (name == nullptr) return id("?");
+	for (Task& task : tasks) {
+		if (task.ready && task.name == name) return task.id;
+	}
+	const std::uint16_t named = id(name);
+	for (Task& task : tasks) {
+		const char* expected = nullptr;
+		if (task.name.compare_exchange_strong(expected, name)) {
+			task.id = named;
+			task.ready = true;
+			break;
+		}
+	}
+	return named;
+}
+
+void add(Kind kind, std::uint16_t name, std::int32_t value) {
+	Record record = {};
+	record.time = clock ? clock() - start : 0;
+	record.value = value;
+	record.name = name;
+	record.task = task_id();
+	record.kind = kind;
+
+	std::uint32_t claimed = head.load(std::memory_order_relaxed);
+	do {
+		if (claimed - tail.load(std::memory_order_acquire) >= capacity) {
+			dropped_count.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	} while (!head.compare_exchange_weak(claimed, claimed + 1, std::memory_order_relaxed));
+
+	Slot& slot = slots[claimed & (capacity - 1)];
+	slot.record = record;
+	slot.sequence.store(claimed + 1, std::memory_order_release);
+}
+
+}  // namespace
+
+void init(Clock source, TaskName task) {
+	clock = source;
+	task_name = task;
+	start = clock ? clock() : 0;
+}
+
+std::uint16_t id(const char* name) {
+	const std::size_t count = name_count.load() < max_names ? name_count.load() : max_names;
+	for (std::size_t i = 0; i < count; i++) {
+		if (names[i].ready && (names[i].text == name || std::strcmp(names[i].text, name) == 0)) return i;
+	}
+	const std::size_t index = name_count++;
+	if (index >= max_names) return max_names - 1; // out of names, shares the last one
+	names[index].text = name;
+	names[index].ready = true;
+	return index;
+}
+
+void begin(std::uint16_t name) { add(Kind::Begin, name, 0); }
+void end(std::uint16_t name) { add(Kind::End, name, 0); }
+void instant(std::uint16_t name) { add(Kind::Instant, name, 0); }
+void counter(std::uint16_t name, std::int32_t value) { add(Kind::Counter, name, value); }
+
+std::size_t flush(FILE* file) {
+	if (!header_written) {
+		const Header header;
+		fwrite(&header, sizeof(header), 1, file);
+		header_written = true;
+	}
+
+	while (names_written < max_names && names_written < name_count.load() && names[names_written].ready) {
+		const char* text = names[names_written].text;
+		Record record = {};
+		record.kind = Kind::Name;
+		record.name = names_written;
+		record.value = std::strlen(text);
+		fwrite(&record, sizeof(record), 1, file);
+		fwrite(text, 1, record.value, file);
+		names_written++;
+	}
+
+	Record chunk[64]; // written a chunk at a time so the sd card sees few large writes
+	std::size_t written = 0;
+	std::size_t filled = 0;
+	std::uint32_t next = tail.load(std::memory_order_relaxed);
+	while (true) {
+		Slot& slot = slots[next & (capacity - 1)];
+		const bool ready = slot.sequence.load(std::memory_order_acquire) == next + 1;
+		if (ready) {
+			chunk[filled++] = slot.record;
+			tail.store(++next, std::memory_order_release);
+		}
+		if (filled == sizeof(chunk) / sizeof(chunk[0]) || (!ready && filled > 0)) {
+			fwrite(chunk, sizeof(Record), filled, file);
+			written += filled;
+			filled = 0;
+		}
+		if (!ready) break;
+	}
+	fflush(file);
+	return written;
+}
+
+std::uint32_t dropped() { return dropped_count; }
+
+}  // namespace robot::trace
@@ -0,0 +1,57 @@
+/**
+ * Runs the replay's iterative learning step on Linux, against files copied off
+ * the SD card. Built by "make host" in the robot directory:
+ *   ./bin/host/ilc_offline recording.txt measured.txt commands.txt
+ *
+ * commands.txt is read if it exists (otherwise the recording is the starting
+ * point) and is overwritten with the refined commands, exactly like disabled()
+ * does on the brain.
+ */
+
+#include "robot/ilc.hpp"
+#include "robot/robot.hpp"
+
+using namespace robot;
+
+int main(int argc, char** argv) {
+	if (argc != 4) {
+		fprintf(stderr, "usage: %s recording.txt measured.txt commands.txt\n", argv[0]);
+		return 1;
+	}
+
+	std::vector<ilc::Frame> commands, reference;
+	ilc::Gains gains;
+	FILE* recording = fopen(argv[1], "r");
+	if (recording == NULL) { perror(argv[1]); return 1; }
+	bool has_arm = false;
+	ilc::read_recording(recording, Robot::curves, &commands, &reference, &gains.period, &has_arm); // old recordings are shaped on this robot's curves
+	if (!has_arm) gains.arm = 0; // the recording never had an arm angle to learn toward
+	fclose(recording);
+	if (commands.empty()) { fprintf(stderr, "%s: no recorded cycles\n", argv[1]); return 1; }
+
+	FILE* measured_file = fopen(argv[2], "r");
+	if (measured_file == NULL) { perror(argv[2]); return 1; }
+	std::vector<ilc::Frame> measured = ilc::read_frames(measured_file, NULL);
+	fclose(measured_file);
+
+	int iteration = 0;
+	FILE* commands_file = fopen(argv[3], "r");
+	if (commands_file != NULL) { // keep refining the previous iteration's commands
+		int refined_iteration = 0;
+		std::vector<ilc::Frame> refined = ilc::read_frames(commands_file, &refined_iteration);
+		fclose(commands_file);
+		if (!refined.empty()) { // an empty file starts over from the recording, as on the brain
+			commands = refined;
+			iteration = refined_iteration;
+		}
+	}
+
+	ilc::Error error = ilc::update(reference, measured, commands, gains);
+	printf("iteration %d: drive rms %.1f rpm, arm rms %.1f cdeg\n", iteration, error.drive, error.arm);
+
+	commands_file = fopen(argv[3], "w");
+	if (commands_file == NULL) { perror(argv[3]); return 1; }
+	ilc::write_frames(commands_file, commands, iteration + 1);
+	fclose(commands_file);
+	return 0;
+}
@@ -0,0 +1,91 @@
+/**
+ * Turns a trace from the brain (/usd/trace.bin, see robot/trace.hpp) into
+ * Chrome trace JSON that Perfetto (ui.perfetto.dev) or chrome://tracing can
+ * open. Built by "make host" in the robot directory:
+ *   ./bin/host/trace_to_json trace.bin trace.json
+ *
+ * Every task gets its own track, spans nest, and counters (mechanism states)
+ * get their own graphs. A trace cut short by a power off converts up to the
+ * last whole record.
+ */
+
+#include "robot/trace.hpp"
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace robot;
+
+// names are string literals from the code, but keep the JSON valid whatever is in them
+static std::string quote(const std::string& text) {
+	std::string quoted = "\"";
+	for (char c : text) {
+		if (c == '"' || c == '\\') quoted += '\\';
+		if ((unsigned char) c < ' ') continue;
+		quoted += c;
+	}
+	return quoted + "\"";
+}
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		fprintf(stderr, "usage: %s trace.bin trace.json\n", argv[0]);
+		return 1;
+	}
+
+	FILE* in = fopen(argv[1], "rb");
+	if (in == NULL) { perror(argv[1]); return 1; }
+	if (!trace::read_header(in)) {
+		fprintf(stderr, "%s: not a trace\n", argv[1]);
+		return 1;
+	}
+
+	// names can be defined after the events that use them, so read everything first
+	std::map<std::uint16_t, std::string> names;
+	std::vector<trace::Record> records;
+	trace::Record record;
+	char text[256];
+	while (trace::read_record(in, &record, text, sizeof(text))) {
+		if (record.kind == trace::Kind::Name) names[record.name] = text;
+		else records.push_back(record);
+	}
+	fclose(in);
+
+	auto name = [&](std::uint16_t id) {
+		auto found = names.find(id);
+		return quote(found != names.end() ? found->second : "#" + std::to_string(id));
+	};
+
+	FILE* out = fopen(argv[2], "w");
+	if (out == NULL) { perror(argv[2]); return 1; }
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+	std::map<std::uint16_t, bool> tasks;
+	for (const trace::Record& event : records) tasks[event.task] = true;
+	for (const auto& task : tasks) { // label each task's track
+		fprintf(out, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":%s}}", first ? "" : ",\n", task.first, name(task.first).c_str());
+		first = false;
+	}
+	for (const trace::Record& event : records) {
+		fprintf(out, "%s", first ? "" : ",\n");
+		first = false;
+		switch (event.kind) {
+			case trace::Kind::Begin:
+			case trace::Kind::End:
+				fprintf(out, "{\"name\":%s,\"ph\":\"%c\",\"ts\":%u,\"pid\":1,\"tid\":%u}", name(event.name).c_str(), event.kind == trace::Kind::Begin ? 'B' : 'E', event.time, event.task);
+				break;
+			case trace::Kind::Instant:
+				fprintf(out, "{\"name\":%s,\"ph\":\"i\",\"s\":\"t\",\"ts\":%u,\"pid\":1,\"tid\":%u}", name(event.name).c_str(), event.time, event.task);
+				break;
+			case trace::Kind::Counter:
+				fprintf(out, "{\"name\":%s,\"ph\":\"C\",\"ts\":%u,\"pid\":1,\"tid\":%u,\"args\":{\"value\":%d}}", name(event.name).c_str(), event.time, event.task, event.value);
+				break;
+			case trace::Kind::Name: break;
+		}
+	}
+	fprintf(out, "\n]}\n");
+	fclose(out);
+
+	printf("%zu events, %zu names\n", records.size(), names.size());
+	return 0;
+}